@@ -0,0 +1,177 @@
+#include "bench.h"
+#include "timer.h"
+
+#include <math.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+BenchConfig bench_config = {
+    .warmup = DEFAULT_BENCH_WARMUP,
+    .repetitions = DEFAULT_BENCH_REPETITIONS,
+    .min_seconds = DEFAULT_BENCH_MIN_SECONDS,
+};
+volatile float bench_sink;
+
+static BenchResult results[MAX_BENCH_RESULTS];
+static int result_count = 0;
+
+void bench_log(const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    vfprintf(bench_config.json ? stderr : stdout, format, args);
+    va_end(args);
+}
+
+static int compare_doubles(const void *a, const void *b) {
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static double time_iterations(BenchFn fn, void *context, long long iterations) {
+    double start = timer_seconds();
+    fn(context, iterations);
+    return timer_seconds() - start;
+}
+
+BenchResult *bench_run(const char *suite, const char *name, BenchFn fn, void *context, long long ops_per_iteration) {
+    if (result_count == MAX_BENCH_RESULTS) {
+        fprintf(stderr, "bench: more than %d results\n", MAX_BENCH_RESULTS);
+        exit(1);
+    }
+
+    // Grow the repetition until it is long enough to time reliably
+    long long iterations = 1;
+    while (time_iterations(fn, context, iterations) < bench_config.min_seconds && iterations < (1ll << 40)) {
+        iterations *= 2;
+    }
+
+    for (int i = 0; i < bench_config.warmup; i++) {
+        time_iterations(fn, context, iterations);
+    }
+
+    int reps = bench_config.repetitions;
+    double samples[reps];
+    double sum = 0;
+    for (int i = 0; i < reps; i++) {
+        samples[i] = time_iterations(fn, context, iterations) * 1e9 / (iterations * ops_per_iteration);
+        sum += samples[i];
+    }
+
+    BenchResult *r = &results[result_count++];
+    *r = (BenchResult){.suite = suite, .iterations = iterations, .mean_ns = sum / reps};
+    snprintf(r->name, sizeof(r->name), "%s", name);
+
+    double squares = 0;
+    for (int i = 0; i < reps; i++) {
+        squares += (samples[i] - r->mean_ns) * (samples[i] - r->mean_ns);
+    }
+    r->stddev_ns = reps > 1 ? sqrt(squares / (reps - 1)) : 0;
+
+    qsort(samples, reps, sizeof(double), compare_doubles);
+    r->min_ns = samples[0];
+    r->median_ns = samples[reps / 2];
+    r->max_ns = samples[reps - 1];
+    r->ops_per_sec = 1e9 / r->mean_ns;
+
+    bench_log("%-6s %-28s %12.2f ns/op %8.2f%% %16.0f ops/sec\n", suite, r->name, r->mean_ns,
+              100 * r->stddev_ns / r->mean_ns, r->ops_per_sec);
+    return r;
+}
+
+static void print_json() {
+    printf("{\n  \"warmup\": %d,\n  \"repetitions\": %d,\n  \"min_seconds\": %g,\n  \"benchmarks\": [\n",
+           bench_config.warmup, bench_config.repetitions, bench_config.min_seconds);
+    for (int i = 0; i < result_count; i++) {
+        const BenchResult *r = &results[i];
+        printf("    {\"suite\": \"%s\", \"name\": \"%s\", \"iterations\": %lld, \"mean_ns\": %.3f, \"stddev_ns\": %.3f, "
+               "\"variance_ns2\": %.3f, \"min_ns\": %.3f, \"median_ns\": %.3f, \"max_ns\": %.3f, \"ops_per_sec\": %.1f",
+               r->suite, r->name, r->iterations, r->mean_ns, r->stddev_ns, r->stddev_ns * r->stddev_ns, r->min_ns,
+               r->median_ns, r->max_ns, r->ops_per_sec);
+        if (r->counter_name != NULL) {
+            printf(", \"%s\": %.3f", r->counter_name, r->counter);
+        }
+        printf("}%s\n", i + 1 < result_count ? "," : "");
+    }
+    printf("  ]\n}\n");
+}
+
+static void print_usage(const char *program) {
+#ifdef PONG_BENCH_SDL
+    const char *suites = "all|batch|sim|fixed|ai|swarm|game";
+#else
+    const char *suites = "all|batch|sim|fixed|ai|swarm";
+#endif
+    fprintf(stderr, "Usage: %s [%s] [--json] [--warmup N] [--repetitions N] [--min-time SECONDS]\n", program, suites);
+}
+
+int main(int argc, char **argv) {
+    const char *suite = "all";
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        bool has_value = i + 1 < argc;
+
+        if (strcmp(arg, "--json") == 0) {
+            bench_config.json = true;
+        } else if (strcmp(arg, "--warmup") == 0 && has_value) {
+            bench_config.warmup = atoi(argv[++i]);
+        } else if (strcmp(arg, "--repetitions") == 0 && has_value) {
+            bench_config.repetitions = atoi(argv[++i]);
+        } else if (strcmp(arg, "--min-time") == 0 && has_value) {
+            bench_config.min_seconds = strtod(argv[++i], NULL);
+        } else if (arg[0] != '-') {
+            suite = arg;
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (bench_config.warmup < 0 || bench_config.repetitions <= 0) {
+        fprintf(stderr, "--warmup can't be negative and --repetitions must be positive\n");
+        return 1;
+    }
+
+    bool all = strcmp(suite, "all") == 0;
+    bool known = all;
+    int status = 0;
+
+    if (status == 0 && (all || strcmp(suite, "batch") == 0)) {
+        known = true;
+        status = bench_batch();
+    }
+    if (status == 0 && (all || strcmp(suite, "sim") == 0)) {
+        known = true;
+        status = bench_sim();
+    }
+    if (status == 0 && (all || strcmp(suite, "fixed") == 0)) {
+        known = true;
+        status = bench_fixed();
+    }
+    if (status == 0 && (all || strcmp(suite, "ai") == 0)) {
+        known = true;
+        status = bench_ai();
+    }
+    if (status == 0 && (all || strcmp(suite, "swarm") == 0)) {
+        known = true;
+        status = bench_swarm();
+    }
+#ifdef PONG_BENCH_SDL
+    if (status == 0 && (all || strcmp(suite, "game") == 0)) {
+        known = true;
+        status = bench_game();
+    }
+#endif
+
+    if (!known) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    if (status == 0 && bench_config.json) {
+        print_json();
+    }
+    return status;
+}
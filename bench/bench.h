@@ -0,0 +1,56 @@
+#pragma once
+
+#include <stdbool.h>
+
+// Every benchmark runs `warmup` untimed repetitions, then `repetitions` timed
+// ones. Each repetition runs enough iterations to last at least min_seconds,
+// and the spread across repetitions is reported alongside the mean.
+
+typedef struct {
+    int warmup;
+    int repetitions;
+    double min_seconds;
+    bool json;
+} BenchConfig;
+
+typedef struct {
+    const char *suite;
+    char name[64];
+    long long iterations;
+    double mean_ns;
+    double stddev_ns;
+    double min_ns;
+    double median_ns;
+    double max_ns;
+    double ops_per_sec;
+    // Optional extra figure, e.g. draw calls per frame
+    const char *counter_name;
+    double counter;
+} BenchResult;
+
+// Runs `iterations` iterations of the benchmarked code
+typedef void (*BenchFn)(void *context, long long iterations);
+
+#define MAX_BENCH_RESULTS 256
+#define DEFAULT_BENCH_WARMUP 2
+#define DEFAULT_BENCH_REPETITIONS 10
+#define DEFAULT_BENCH_MIN_SECONDS 0.05
+
+extern BenchConfig bench_config;
+// Results are written here so the compiler can't drop the benchmarked work
+extern volatile float bench_sink;
+
+// Times fn and records the result. Per-op figures divide by ops_per_iteration,
+// e.g. the number of matches in one batched step.
+BenchResult *bench_run(const char *suite, const char *name, BenchFn fn, void *context, long long ops_per_iteration);
+// Log lines go to stderr in JSON mode so stdout stays parseable
+void bench_log(const char *format, ...);
+
+int bench_batch();
+int bench_sim();
+int bench_fixed();
+int bench_ai();
+int bench_swarm();
+#ifdef PONG_BENCH_SDL
+int bench_game();
+#endif
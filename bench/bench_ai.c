@@ -0,0 +1,212 @@
+#include "bench.h"
+
+#include "ai.h"
+#include "batch.h"
+#include "headless.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define VERIFY_BALLS 100000
+// Nearly vertical balls bounce more often on the way than one sweep resolves
+#define VERIFY_MIN_DIR_X 0.25f
+#define PREDICTION_TOLERANCE 0.01f
+
+// A recorded stretch of play the players are timed on, so the ball changes
+// direction as often as it does in a real match
+#define TRACE_TICKS 4096
+#define BATCH_MATCHES 4096
+
+static const float dt = HEADLESS_DEFAULT_DT;
+
+// Paddles out of the way, so the ball flies through to the face
+static void paddles_out_of_reach(Paddle *p1, Paddle *p2) {
+    Match match;
+    match_init(&match, 1);
+    *p1 = match.p1;
+    *p2 = match.p2;
+    p1->pos.y = -10 * SCREEN_HEIGHT;
+    p2->pos.y = -10 * SCREEN_HEIGHT;
+}
+
+static float face_x(bool is_left_side) {
+    return is_left_side ? 2 * PADDLE_WIDTH + 16 : SCREEN_WIDTH - PADDLE_WIDTH - 16 - BALL_RADIUS;
+}
+
+// The closed-form prediction against sweep_ball flying the same ball there
+static bool verify_prediction() {
+    Paddle p1;
+    Paddle p2;
+    paddles_out_of_reach(&p1, &p2);
+
+    Match match;
+    match_init(&match, 3);
+    uint64_t rng = 17;
+    float error = 0;
+
+    for (int i = 0; i < VERIFY_BALLS; i++) {
+        Ball ball = match.ball;
+        set_random_dir_ball(&match, &ball);
+        if (fabsf(ball.dir.x) < VERIFY_MIN_DIR_X) {
+            continue;
+        }
+        float left = face_x(true);
+        float right = face_x(false);
+        ball.pos.x = left + random_float(&rng) * (right - left);
+        ball.pos.y = random_float(&rng) * (SCREEN_HEIGHT - BALL_RADIUS);
+
+        float face = face_x(ball.dir.x < 0);
+        float predicted = ai_predict_y(ball.pos, ball.dir, face);
+        sweep_ball(&ball, &p1, &p2, (face - ball.pos.x) / (ball.dir.x * ball.speed));
+
+        float difference = fabsf(predicted - ball.pos.y);
+        if (!(difference <= error)) {
+            error = difference;
+        }
+    }
+
+    bench_log("verify: predicted intercepts within %.2g px of the swept ball\n", error);
+    if (!(error <= PREDICTION_TOLERANCE)) {
+        fprintf(stderr, "verify: ai_predict_y is off by %g px\n", error);
+        return false;
+    }
+    return true;
+}
+
+typedef struct {
+    Match states[TRACE_TICKS];
+    AiPlayer ai;
+    Paddle p1;
+    Paddle p2;
+    long long ticks;
+    long long predictions;
+} TraceBench;
+
+// Two CPU players at normal difficulty against each other
+static void record_trace(TraceBench *bench) {
+    Match match;
+    match_init(&match, 5);
+    AiPlayer p1;
+    AiPlayer p2;
+    ai_init(&p1, AI_NORMAL, true, 1);
+    ai_init(&p2, AI_NORMAL, false, 2);
+
+    float time = 0;
+    for (int i = 0; i < TRACE_TICKS; i++) {
+        bench->states[i] = match;
+        MatchInput input = {.p1 = ai_input(&p1, &match, dt), .p2 = ai_input(&p2, &match, dt), .serve = true};
+        step_match(&match, input, dt, time);
+        time += dt;
+    }
+}
+
+static void bench_cached(void *context, long long iterations) {
+    TraceBench *bench = context;
+    int sum = 0;
+
+    long long before = bench->ai.predictions;
+    for (long long i = 0; i < iterations; i++) {
+        sum += ai_input(&bench->ai, &bench->states[i & (TRACE_TICKS - 1)], dt);
+    }
+    bench->ticks += iterations;
+    bench->predictions += bench->ai.predictions - before;
+    bench_sink = (float)sum;
+}
+
+// The headless AI, which only chases the ball's current height
+static void bench_reactive(void *context, long long iterations) {
+    const TraceBench *bench = context;
+    int sum = 0;
+
+    for (long long i = 0; i < iterations; i++) {
+        sum += headless_player_input(PLAYER_AI, &bench->states[i & (TRACE_TICKS - 1)], false, 0, 0);
+    }
+    bench_sink = (float)sum;
+}
+
+// What the prediction would cost found by flying a copy of the ball to the
+// paddle every tick instead
+static void bench_trajectory(void *context, long long iterations) {
+    const TraceBench *bench = context;
+    const float face = face_x(false);
+    float sum = 0;
+
+    for (long long i = 0; i < iterations; i++) {
+        const Match *match = &bench->states[i & (TRACE_TICKS - 1)];
+        Ball ball = match->ball;
+        if (match->hasStarted && ball.dir.x > 0) {
+            while (ball.pos.x < face && sweep_ball(&ball, &bench->p1, &bench->p2, dt) == MATCH_EVENT_NONE) {
+            }
+        }
+        sum += ball.pos.y;
+    }
+    bench_sink = sum;
+}
+
+typedef struct {
+    PongBatch *batch;
+    AiPlayer *players;
+    int8_t *actions;
+    bool with_ai;
+} BatchAiBench;
+
+static void bench_batch_ai(void *context, long long iterations) {
+    BatchAiBench *bench = context;
+
+    for (long long i = 0; i < iterations; i++) {
+        if (bench->with_ai) {
+            pong_batch_ai_actions(bench->batch, bench->players, bench->actions, dt);
+        }
+        pong_batch_step(bench->batch, bench->actions, dt);
+    }
+    bench_sink = bench->batch->ball_x[0];
+}
+
+static void bench_batched_players(bool with_ai) {
+    PongBatch *batch = pong_batch_create(BATCH_MATCHES, 9);
+    AiPlayer *players = malloc(2 * BATCH_MATCHES * sizeof(AiPlayer));
+    int8_t *actions = calloc(2 * BATCH_MATCHES, 1);
+    if (batch == NULL || players == NULL || actions == NULL) {
+        fprintf(stderr, "ai: out of memory\n");
+        exit(1);
+    }
+    batch->kernel = pong_batch_best_kernel();
+    for (int i = 0; i < 2 * BATCH_MATCHES; i++) {
+        ai_init(&players[i], AI_NORMAL, i < BATCH_MATCHES, (uint64_t)i);
+    }
+
+    // One op is one match stepped once, with or without both players thinking
+    char name[64];
+    snprintf(name, sizeof(name), "%s/%d", with_ai ? "batch+ai" : "batch", BATCH_MATCHES);
+    BatchAiBench bench = {batch, players, actions, with_ai};
+    bench_run("ai", name, bench_batch_ai, &bench, BATCH_MATCHES);
+
+    free(actions);
+    free(players);
+    pong_batch_destroy(batch);
+}
+
+int bench_ai() {
+    if (!verify_prediction()) {
+        return 1;
+    }
+
+    static TraceBench trace;
+    record_trace(&trace);
+    paddles_out_of_reach(&trace.p1, &trace.p2);
+    ai_init(&trace.ai, AI_NORMAL, false, 7);
+
+    // One op is one player's decision for one tick
+    BenchResult *result = bench_run("ai", "cached", bench_cached, &trace, 1);
+    if (result != NULL && trace.ticks > 0) {
+        result->counter_name = "predictions_per_1k_ticks";
+        result->counter = 1000.0 * trace.predictions / trace.ticks;
+    }
+    bench_run("ai", "reactive", bench_reactive, &trace, 1);
+    bench_run("ai", "trajectory", bench_trajectory, &trace, 1);
+
+    bench_batched_players(false);
+    bench_batched_players(true);
+    return 0;
+}
@@ -0,0 +1,192 @@
+#include "bench.h"
+
+#include "batch.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define VERIFY_MATCHES 1003
+#define VERIFY_STEPS 20000
+
+static void random_actions(uint64_t *rng, int8_t *actions, int count) {
+    for (int i = 0; i < count; i++) {
+        actions[i] = (int8_t)(random_u64(rng) % 3) - 1;
+    }
+}
+
+static bool same_bits(const void *a, const void *b, size_t size) {
+    return memcmp(a, b, size) == 0;
+}
+
+// The fixed kernel against fixed_step_match, lane by lane
+static bool verify_fixed_kernel() {
+    const float dts[] = {1.0f / 120.0f, 1.0f / 60.0f, 1.0f / 30.0f, 0.1f};
+    const int count = VERIFY_MATCHES;
+    uint64_t seed = 7;
+    bool ok = true;
+
+    PongBatch *batch = pong_batch_create(count, seed);
+    FixedMatch *matches = malloc(count * sizeof(FixedMatch));
+    int8_t *actions = malloc(2 * count);
+    if (batch == NULL || matches == NULL || actions == NULL) {
+        fprintf(stderr, "verify: out of memory\n");
+        exit(1);
+    }
+    batch->kernel = BATCH_KERNEL_FIXED;
+
+    for (int i = 0; i < count; i++) {
+        pong_fixed_match_init(&matches[i], random_u64(&seed));
+    }
+
+    uint64_t rng = 99;
+    for (int step = 0; step < VERIFY_STEPS && ok; step++) {
+        float dt = dts[step % 4];
+        random_actions(&rng, actions, 2 * count);
+        pong_batch_step(batch, actions, dt);
+
+        for (int i = 0; i < count && ok; i++) {
+            bool done;
+            float reward = pong_fixed_match_step(&matches[i], actions[i], actions[count + i], fixed_from_float(dt), &done);
+
+            FixedMatch lane;
+            pong_batch_load_fixed_match(batch, i, &lane);
+            const FixedMatch *m = &matches[i];
+
+            ok = lane.ball.pos.x == m->ball.pos.x && lane.ball.pos.y == m->ball.pos.y &&
+                 lane.ball.dir.x == m->ball.dir.x && lane.ball.dir.y == m->ball.dir.y &&
+                 lane.p1.pos.y == m->p1.pos.y && lane.p2.pos.y == m->p2.pos.y && lane.p1.score == m->p1.score &&
+                 lane.p2.score == m->p2.score && lane.rng == m->rng && batch->rewards[i] == reward &&
+                 batch->dones[i] == done;
+            if (!ok) {
+                fprintf(stderr, "verify: fixed diverged from fixed_step_match at step %d, match %d\n", step, i);
+            }
+        }
+    }
+
+    free(actions);
+    free(matches);
+    pong_batch_destroy(batch);
+    return ok;
+}
+
+// Steps a batch and one Match per lane side by side and fails on the first
+// bit that differs.
+static bool verify_kernel(BatchKernel kernel) {
+    if (kernel == BATCH_KERNEL_FIXED) {
+        return verify_fixed_kernel();
+    }
+
+    // Includes coarse steps that need several bounces resolved per step
+    const float dts[] = {1.0f / 120.0f, 1.0f / 60.0f, 1.0f / 30.0f, 0.1f};
+    const int count = VERIFY_MATCHES;
+    uint64_t seed = 7;
+    bool ok = true;
+
+    PongBatch *batch = pong_batch_create(count, seed);
+    Match *matches = malloc(count * sizeof(Match));
+    int8_t *actions = malloc(2 * count);
+    if (batch == NULL || matches == NULL || actions == NULL) {
+        fprintf(stderr, "verify: out of memory\n");
+        exit(1);
+    }
+    batch->kernel = kernel;
+
+    for (int i = 0; i < count; i++) {
+        pong_match_init(&matches[i], random_u64(&seed));
+    }
+
+    uint64_t rng = 99;
+    for (int step = 0; step < VERIFY_STEPS && ok; step++) {
+        float dt = dts[step % 4];
+        random_actions(&rng, actions, 2 * count);
+        pong_batch_step(batch, actions, dt);
+
+        for (int i = 0; i < count && ok; i++) {
+            bool done;
+            float reward = pong_match_step(&matches[i], actions[i], actions[count + i], dt, &done);
+
+            Match lane;
+            pong_batch_load_match(batch, i, &lane);
+            const Match *m = &matches[i];
+
+            ok = same_bits(&lane.ball.pos, &m->ball.pos, sizeof(Vector2D)) &&
+                 same_bits(&lane.ball.dir, &m->ball.dir, sizeof(Vector2D)) &&
+                 same_bits(&lane.p1.pos.y, &m->p1.pos.y, sizeof(float)) &&
+                 same_bits(&lane.p2.pos.y, &m->p2.pos.y, sizeof(float)) &&
+                 lane.p1.score == m->p1.score && lane.p2.score == m->p2.score && lane.rng == m->rng &&
+                 same_bits(&batch->rewards[i], &reward, sizeof(float)) && batch->dones[i] == done;
+            if (!ok) {
+                fprintf(stderr, "verify: %s diverged from the scalar path at step %d, match %d\n",
+                        pong_batch_kernel_name(kernel), step, i);
+            }
+        }
+    }
+
+    free(actions);
+    free(matches);
+    pong_batch_destroy(batch);
+    return ok;
+}
+
+typedef struct {
+    PongBatch *batch;
+    const int8_t *actions;
+} BatchBench;
+
+static void step_batch(void *context, long long iterations) {
+    BatchBench *bench = context;
+    for (long long i = 0; i < iterations; i++) {
+        pong_batch_step(bench->batch, bench->actions, 1.0f / 120.0f);
+    }
+    bench_sink = bench->batch->rewards[0];
+}
+
+static void bench_kernel(BatchKernel kernel, int count) {
+    PongBatch *batch = pong_batch_create(count, 1);
+    int8_t *actions = malloc(2 * count);
+    if (batch == NULL || actions == NULL) {
+        fprintf(stderr, "bench: out of memory\n");
+        exit(1);
+    }
+    batch->kernel = kernel;
+
+    uint64_t rng = 3;
+    random_actions(&rng, actions, 2 * count);
+
+    // One op is one match stepped once
+    char name[64];
+    snprintf(name, sizeof(name), "%s/%d", pong_batch_kernel_name(kernel), count);
+    BatchBench bench = {batch, actions};
+    bench_run("batch", name, step_batch, &bench, count);
+
+    free(actions);
+    pong_batch_destroy(batch);
+}
+
+int bench_batch() {
+    const int sizes[] = {1, 16, 256, 4096, 65536};
+    const BatchKernel kernels[] = {BATCH_KERNEL_SCALAR, BATCH_KERNEL_SSE2, BATCH_KERNEL_AVX2, BATCH_KERNEL_FIXED};
+    const int kernel_count = sizeof(kernels) / sizeof(kernels[0]);
+
+    for (int k = 0; k < kernel_count; k++) {
+        if (!pong_batch_kernel_supported(kernels[k])) {
+            continue;
+        }
+        if (!verify_kernel(kernels[k])) {
+            return 1;
+        }
+        bench_log("verify: %s matches the scalar path bit for bit\n", pong_batch_kernel_name(kernels[k]));
+    }
+
+    for (int k = 0; k < kernel_count; k++) {
+        if (!pong_batch_kernel_supported(kernels[k])) {
+            continue;
+        }
+        for (int s = 0; s < 5; s++) {
+            bench_kernel(kernels[k], sizes[s]);
+        }
+    }
+
+    return 0;
+}
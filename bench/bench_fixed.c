@@ -0,0 +1,156 @@
+#include "bench.h"
+
+#include "headless.h"
+#include "sim_fixed.h"
+
+#include <math.h>
+#include <stdio.h>
+
+#define CROSS_CHECK_MATCHES 256
+#define CROSS_CHECK_TICKS 5000
+// How far the backends may drift apart in one tick from the same state
+#define POSITION_TOLERANCE 0.1f
+#define DIRECTION_TOLERANCE 1e-3f
+// Ticks whose outcome may flip on rounding, e.g. a ball just grazing a paddle corner
+#define MAX_OUTCOME_MISMATCH_RATE 1e-4
+// Ticks where a paddle stops a step short of the edge on one side only
+#define MAX_EDGE_FLIP_RATE 1e-2
+
+#define AGREEMENT_MATCHES 200
+
+static void track_error(float *error, float a, float b) {
+    float difference = fabsf(a - b);
+    if (difference > *error) {
+        *error = difference;
+    }
+}
+
+// Steps the float path, and the fixed path from the nearest fixed state, one
+// tick at a time and checks they land in the same place
+static bool cross_check() {
+    const float dts[] = {1.0f / 120.0f, 1.0f / 60.0f, 1.0f / 30.0f, 0.1f};
+    uint64_t rng = 11;
+    long long ticks = 0;
+    long long mismatches = 0;
+    long long edge_flips = 0;
+    float position_error = 0;
+    float direction_error = 0;
+
+    for (int m = 0; m < CROSS_CHECK_MATCHES; m++) {
+        Match match;
+        match_init(&match, random_u64(&rng));
+        float time = 0;
+
+        for (int tick = 0; tick < CROSS_CHECK_TICKS; tick++) {
+            float dt = dts[(m + tick) % 4];
+            uint64_t bits = random_u64(&rng);
+            MatchInput input = {
+                .p1 = (int8_t)(bits % 3) - 1,
+                .p2 = (int8_t)(bits / 3 % 3) - 1,
+                // Sometimes wait a while, so the idle animation is covered too
+                .serve = (bits >> 32) % 64 == 0,
+            };
+
+            FixedMatch fixed_match;
+            fixed_match_from_float(&match, &fixed_match);
+            MatchEvent fixed_event = fixed_step_match(&fixed_match, input, fixed_from_float(dt), fixed_from_float(time));
+            MatchEvent event = step_match(&match, input, dt, time);
+            time += dt;
+            ticks++;
+
+            Match view;
+            fixed_match_to_float(&fixed_match, &view);
+            // Paddles move in whole steps, so the float one lands exactly on the
+            // edge all the time, and then the rounded fixed dt can go either way.
+            // Only the paddles are let off; the ball is still checked.
+            bool edge_flip = fabsf(match.p1.pos.y - view.p1.pos.y) > 1 || fabsf(match.p2.pos.y - view.p2.pos.y) > 1;
+            edge_flips += edge_flip;
+
+            // A bounce taken on one side and not the other shows as a flipped direction
+            bool bounced_alike = (match.ball.dir.x < 0) == (view.ball.dir.x < 0) &&
+                                 (match.ball.dir.y < 0) == (view.ball.dir.y < 0);
+            if (event != fixed_event || !bounced_alike || match.hasStarted != view.hasStarted ||
+                match.rng != view.rng || match.p1.score != view.p1.score || match.p2.score != view.p2.score) {
+                mismatches += !edge_flip;
+                continue;
+            }
+
+            track_error(&position_error, match.ball.pos.x, view.ball.pos.x);
+            track_error(&position_error, match.ball.pos.y, view.ball.pos.y);
+            if (!edge_flip) {
+                track_error(&position_error, match.p1.pos.y, view.p1.pos.y);
+                track_error(&position_error, match.p2.pos.y, view.p2.pos.y);
+            }
+            track_error(&direction_error, match.ball.dir.x, view.ball.dir.x);
+            track_error(&direction_error, match.ball.dir.y, view.ball.dir.y);
+        }
+    }
+
+    bench_log("cross-check: %lld ticks, %lld outcome mismatches, %lld paddle edge flips, max error %.2g px, "
+              "direction %.2g\n", ticks, mismatches, edge_flips, position_error, direction_error);
+    if (position_error > POSITION_TOLERANCE || direction_error > DIRECTION_TOLERANCE ||
+        mismatches > ticks * MAX_OUTCOME_MISMATCH_RATE || edge_flips > ticks * MAX_EDGE_FLIP_RATE) {
+        fprintf(stderr, "cross-check: the fixed backend disagrees with the float one (at most %.2g px, %.2g of ticks "
+                "with another outcome and %.2g with a paddle edge flip are allowed)\n", POSITION_TOLERANCE,
+                MAX_OUTCOME_MISMATCH_RATE, MAX_EDGE_FLIP_RATE);
+        return false;
+    }
+    return true;
+}
+
+typedef struct {
+    PhysicsBackend physics;
+    uint64_t rng;
+    long long ticks;
+    long long matches;
+} HeadlessBench;
+
+static void bench_play_match(void *context, long long iterations) {
+    HeadlessBench *bench = context;
+    const PlayerProfile player = {.kind = PLAYER_AI, .aim_error = DEFAULT_AIM_ERROR};
+
+    for (long long i = 0; i < iterations; i++) {
+        MatchResult result;
+        play_match(random_u64(&bench->rng), &player, &player, HEADLESS_DEFAULT_DT, bench->physics, &result, NULL);
+        bench->ticks += result.ticks;
+        bench->matches++;
+    }
+    bench_sink = (float)bench->ticks;
+}
+
+static void bench_headless(const char *name, PhysicsBackend physics) {
+    HeadlessBench bench = {.physics = physics, .rng = 1};
+
+    // One op is one whole match
+    BenchResult *result = bench_run("fixed", name, bench_play_match, &bench, 1);
+    if (result != NULL && bench.matches > 0) {
+        result->counter_name = "ticks_per_sec";
+        result->counter = (double)bench.ticks / bench.matches / (result->mean_ns * 1e-9);
+    }
+}
+
+int bench_fixed() {
+    if (!cross_check()) {
+        return 1;
+    }
+
+    // Over whole matches small differences add up, so outcomes drift apart;
+    // this shows how much, rather than checking anything
+    const PlayerProfile player = {.kind = PLAYER_AI, .aim_error = DEFAULT_AIM_ERROR};
+    uint64_t rng = 3;
+    int same = 0;
+    for (int i = 0; i < AGREEMENT_MATCHES; i++) {
+        uint64_t seed = random_u64(&rng);
+        MatchResult a;
+        MatchResult b;
+        play_match(seed, &player, &player, HEADLESS_DEFAULT_DT, PHYSICS_FLOAT, &a, NULL);
+        play_match(seed, &player, &player, HEADLESS_DEFAULT_DT, PHYSICS_FIXED, &b, NULL);
+        same += a.p1_score == b.p1_score && a.p2_score == b.p2_score && a.ticks == b.ticks;
+    }
+    bench_log("agreement: %d of %d headless matches end with the same score after the same number of ticks\n", same,
+              AGREEMENT_MATCHES);
+
+    bench_headless("headless/float", PHYSICS_FLOAT);
+    bench_headless("headless/fixed", PHYSICS_FIXED);
+    return 0;
+}
@@ -0,0 +1,155 @@
+#include "bench.h"
+
+#include "game.h"
+
+#define KEY_PATTERNS 4
+
+typedef struct {
+    Uint8 keys[KEY_PATTERNS][SDL_NUM_SCANCODES];
+    long long frames;
+    long long draw_calls;
+    long long dropped;
+} InputBench;
+
+static void bench_handle_player_input(void *context, long long iterations) {
+    const InputBench *bench = context;
+    int sum = 0;
+
+    for (long long i = 0; i < iterations; i++) {
+        MatchInput input = handle_player_input(bench->keys[i & (KEY_PATTERNS - 1)]);
+        sum += input.p1 + input.p2;
+    }
+    bench_sink = sum;
+}
+
+// One full frame: a tick of play so the picture changes, then render()
+static void bench_render(void *context, long long iterations) {
+    InputBench *bench = context;
+    const float dt = 1.0f / DEFAULT_TICK_RATE;
+    static float total_time = 0;
+
+    for (long long i = 0; i < iterations; i++) {
+        Match *match = &gState->match;
+        if (is_match_over(match)) {
+            reset_paddles(match, false);
+        }
+
+        gState->prev_match = *match;
+        MatchInput input = handle_player_input(bench->keys[i & (KEY_PATTERNS - 1)]);
+        input.serve = true;
+        total_time += dt;
+        step_match(match, input, dt, total_time);
+
+        render(0.5f);
+        bench->frames++;
+        bench->draw_calls += gState->render_queue.stats.draw_calls;
+        bench->dropped += gState->render_queue.stats.dropped;
+    }
+}
+
+typedef struct {
+    int count;
+    long long frames;
+    long long draw_calls;
+    long long dropped;
+} QueueBench;
+
+// `count` quads moving every frame, half solid in many colours, half glyphs
+static void bench_render_queue(void *context, long long iterations) {
+    QueueBench *bench = context;
+    RenderQueue *queue = &gState->render_queue;
+    const GlyphAtlas *atlas = &gState->atlas;
+
+    for (long long i = 0; i < iterations; i++) {
+        render_queue_begin(queue, (SDL_Color){0, 0, 0, 0xFF});
+
+        for (int q = 0; q < bench->count; q++) {
+            float x = (q * 37 + bench->frames * 3) % (SCREEN_WIDTH - 16);
+            float y = (q * 53 + bench->frames * 2) % (SCREEN_HEIGHT - 16);
+            SDL_Color color = {(Uint8)(q * 50), (Uint8)(q * 90), (Uint8)(q * 130), 0xFF};
+
+            if (q & 1) {
+                const SDL_Rect *src = &atlas->glyphs[q % GLYPH_COUNT].src;
+                SDL_FRect uv = {(float)src->x / atlas->width, (float)src->y / atlas->height,
+                                (float)src->w / atlas->width, (float)src->h / atlas->height};
+                push_textured_quad(queue, LAYER_HUD, atlas->texture, (SDL_FRect){x, y, src->w, src->h}, uv, color);
+            } else {
+                push_rect(queue, LAYER_FIELD, (SDL_FRect){x, y, 8, 8}, color, SDL_BLENDMODE_NONE);
+            }
+        }
+
+        render_queue_flush(queue, gState->renderer);
+        SDL_RenderPresent(gState->renderer);
+        bench->frames++;
+        bench->draw_calls += queue->stats.draw_calls;
+        bench->dropped += queue->stats.dropped;
+    }
+}
+
+// Packing a rendered frame for the capture, without writing it anywhere
+static void bench_capture_frame(void *context, long long iterations) {
+    FrameCapture *capture = context;
+
+    for (long long i = 0; i < iterations; i++) {
+        capture_frame(capture);
+    }
+    bench_sink = (float)capture->frame_count;
+}
+
+static void report_draw_calls(BenchResult *result, long long frames, long long draw_calls, long long dropped) {
+    result->counter_name = "draw_calls_per_frame";
+    result->counter = (double)draw_calls / frames;
+    bench_log("%-6s %-28s %12.2f draw calls/frame, %lld quads dropped\n", result->suite, result->name,
+              result->counter, dropped);
+}
+
+int bench_game() {
+    // No display or GPU needed: SDL's dummy video driver and the software renderer
+    SDL_SetHint(SDL_HINT_VIDEODRIVER, "dummy");
+
+    GameOptions options = {
+        .tick_rate = DEFAULT_TICK_RATE,
+        .frame_rate = DEFAULT_FRAME_RATE,
+        .pacing = PACING_UNCAPPED,
+        .software_renderer = true,
+    };
+    if (!init(&options)) {
+        fprintf(stderr, "bench: failed to init SDL with the dummy video driver\n");
+        return 1;
+    }
+
+    // W, S, UP + S, nothing held: every branch of the key mapping
+    static InputBench bench;
+    bench.keys[0][SDL_SCANCODE_W] = 1;
+    bench.keys[1][SDL_SCANCODE_S] = 1;
+    bench.keys[2][SDL_SCANCODE_UP] = 1;
+    bench.keys[2][SDL_SCANCODE_S] = 1;
+
+    bench_run("game", "handle_player_input", bench_handle_player_input, &bench, 1);
+    BenchResult *result = bench_run("game", "render", bench_render, &bench, 1);
+    report_draw_calls(result, bench.frames, bench.draw_calls, bench.dropped);
+
+    // Draw calls should stay flat as the quad count grows
+    const int counts[] = {16, 256, RENDER_QUEUE_CAPACITY};
+    for (int i = 0; i < 3; i++) {
+        char name[64];
+        snprintf(name, sizeof(name), "render_queue/%d", counts[i]);
+        QueueBench queue_bench = {.count = counts[i]};
+        result = bench_run("game", name, bench_render_queue, &queue_bench, 1);
+        report_draw_calls(result, queue_bench.frames, queue_bench.draw_calls, queue_bench.dropped);
+    }
+
+    const CaptureFormat formats[] = {CAPTURE_Y4M, CAPTURE_RGBA};
+    const char *format_names[] = {"capture/y4m", "capture/rgba"};
+    for (int i = 0; i < 2; i++) {
+        static FrameCapture capture;
+        if (!capture_open(&capture, NULL, NULL, formats[i], DEFAULT_FRAME_RATE, false)) {
+            return 1;
+        }
+        bench_run("game", format_names[i], bench_capture_frame, &capture, 1);
+        capture_destroy(&capture);
+    }
+
+    cleanup();
+    return 0;
+}
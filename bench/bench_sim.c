@@ -0,0 +1,80 @@
+#include "bench.h"
+
+#include "sim.h"
+
+#define SAMPLE_COUNT 1024
+
+typedef struct {
+    Match match;
+    float time;
+} GameBench;
+
+static void bench_update_game(void *context, long long iterations) {
+    GameBench *bench = context;
+    const float dt = 1.0f / 120.0f;
+
+    for (long long i = 0; i < iterations; i++) {
+        if (!bench->match.hasStarted) {
+            serve_ball(&bench->match);
+        }
+        bench->time += dt;
+        update_game(&bench->match, dt, bench->time);
+    }
+    bench_sink = bench->match.ball.pos.x;
+}
+
+// Balls spread over the whole field, so both the hit and the miss paths run
+typedef struct {
+    Ball balls[SAMPLE_COUNT];
+    Paddle p1;
+    Paddle p2;
+} CollisionBench;
+
+static void bench_check_collision(void *context, long long iterations) {
+    const CollisionBench *bench = context;
+    float sum = 0;
+
+    for (long long i = 0; i < iterations; i++) {
+        const Ball *ball = &bench->balls[i & (SAMPLE_COUNT - 1)];
+        float t = check_collision(ball, ball->dir.x < 0 ? &bench->p1 : &bench->p2, ball->dir.x < 0);
+        sum += t < 1 ? t : 0;
+    }
+    bench_sink = sum;
+}
+
+static void bench_reflect_vec(void *context, long long iterations) {
+    const CollisionBench *bench = context;
+    const Vector2D normal = get_paddle_normal(true);
+    float sum = 0;
+
+    for (long long i = 0; i < iterations; i++) {
+        Vector2D r = reflect_vec(bench->balls[i & (SAMPLE_COUNT - 1)].dir, normal);
+        sum += r.x + r.y;
+    }
+    bench_sink = sum;
+}
+
+int bench_sim() {
+    GameBench game = {0};
+    match_init(&game.match, 1);
+    bench_run("sim", "update_game", bench_update_game, &game, 1);
+
+    static CollisionBench collision;
+    Match match;
+    match_init(&match, 2);
+    collision.p1 = match.p1;
+    collision.p2 = match.p2;
+
+    uint64_t rng = 5;
+    for (int i = 0; i < SAMPLE_COUNT; i++) {
+        Ball *ball = &collision.balls[i];
+        *ball = match.ball;
+        ball->pos.x = random_float(&rng) * (SCREEN_WIDTH - BALL_RADIUS);
+        ball->pos.y = random_float(&rng) * (SCREEN_HEIGHT - BALL_RADIUS);
+        set_random_dir_ball(&match, ball);
+    }
+
+    bench_run("sim", "check_collision", bench_check_collision, &collision, 1);
+    bench_run("sim", "reflect_vec", bench_reflect_vec, &collision, 1);
+    return 0;
+}
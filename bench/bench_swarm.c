@@ -0,0 +1,167 @@
+#include "bench.h"
+
+#include "swarm.h"
+
+#include <math.h>
+#include <stdio.h>
+
+#define VERIFY_STEPS 200
+#define VERIFY_BALLS 2000
+
+static const float dt = 1.0f / 120.0f;
+
+// Every pair against every other, as the grid is there to avoid
+static long long count_contacts_brute(const Swarm *swarm) {
+    long long contacts = 0;
+    for (int a = 0; a < swarm->used; a++) {
+        if (!swarm->balls[a].isAlive) {
+            continue;
+        }
+        for (int b = a + 1; b < swarm->used; b++) {
+            const Vector2D pa = swarm->balls[a].pos;
+            const Vector2D pb = swarm->balls[b].pos;
+            if (swarm->balls[b].isAlive && fabsf(pa.x - pb.x) < SWARM_BALL_SIZE &&
+                fabsf(pa.y - pb.y) < SWARM_BALL_SIZE) {
+                contacts++;
+            }
+        }
+    }
+    return contacts;
+}
+
+// The grid must find exactly the touching pairs brute force finds, and the
+// pool must hand freed slots out again rather than grow
+static bool verify_swarm() {
+    Swarm swarm;
+    if (!swarm_init(&swarm, VERIFY_BALLS, 1)) {
+        fprintf(stderr, "swarm: out of memory\n");
+        return false;
+    }
+    swarm_spawn_random(&swarm, VERIFY_BALLS);
+
+    Match match;
+    match_init(&match, 1);
+    bool ok = true;
+
+    for (int step = 0; step < VERIFY_STEPS && ok; step++) {
+        // Churn half the pool now and then
+        if (step % 50 == 25) {
+            swarm_despawn_some(&swarm, VERIFY_BALLS / 2);
+            swarm_spawn_random(&swarm, VERIFY_BALLS / 2);
+            ok = swarm.used == VERIFY_BALLS && swarm.count == VERIFY_BALLS;
+            if (!ok) {
+                fprintf(stderr, "swarm: the pool grew to %d slots for %d balls\n", swarm.used, swarm.count);
+            }
+        }
+
+        swarm.stats = (SwarmStats){0};
+        swarm_move(&swarm, dt);
+        swarm_build_grid(&swarm);
+        swarm_find_contacts(&swarm);
+        long long brute = count_contacts_brute(&swarm);
+        if (ok && swarm.stats.contacts != brute) {
+            fprintf(stderr, "swarm: the grid found %lld contacts at step %d, brute force %lld\n", swarm.stats.contacts,
+                    step, brute);
+            ok = false;
+        }
+        swarm_resolve_contacts(&swarm);
+        swarm_hit_paddles(&swarm, &match.p1, &match.p2);
+    }
+
+    swarm_destroy(&swarm);
+    if (ok) {
+        bench_log("verify: the grid finds the same contacts as brute force; freed slots are reused\n");
+    }
+    return ok;
+}
+
+typedef struct {
+    Swarm swarm;
+    Match match;
+    long long steps;
+    long long candidates;
+    long long contacts;
+} SwarmBench;
+
+static void bench_step(void *context, long long iterations) {
+    SwarmBench *bench = context;
+
+    for (long long i = 0; i < iterations; i++) {
+        swarm_step(&bench->swarm, &bench->match.p1, &bench->match.p2, dt);
+        bench->candidates += bench->swarm.stats.candidates;
+        bench->contacts += bench->swarm.stats.contacts;
+    }
+    bench->steps += iterations;
+    bench_sink = bench->swarm.balls[0].pos.x;
+}
+
+// Moving the balls, then finding every contact: through the grid or by brute
+// force, over the same freshly moved positions each time
+static void bench_grid_contacts(void *context, long long iterations) {
+    SwarmBench *bench = context;
+    long long contacts = 0;
+
+    for (long long i = 0; i < iterations; i++) {
+        bench->swarm.stats = (SwarmStats){0};
+        swarm_move(&bench->swarm, dt);
+        swarm_build_grid(&bench->swarm);
+        swarm_find_contacts(&bench->swarm);
+        contacts += bench->swarm.stats.contacts;
+    }
+    bench_sink = (float)contacts;
+}
+
+static void bench_brute_contacts(void *context, long long iterations) {
+    SwarmBench *bench = context;
+    long long contacts = 0;
+
+    for (long long i = 0; i < iterations; i++) {
+        swarm_move(&bench->swarm, dt);
+        contacts += count_contacts_brute(&bench->swarm);
+    }
+    bench_sink = (float)contacts;
+}
+
+static void bench_count(int count, bool brute) {
+    static SwarmBench bench;
+    bench = (SwarmBench){0};
+    if (!swarm_init(&bench.swarm, count, 3)) {
+        fprintf(stderr, "swarm: out of memory\n");
+        return;
+    }
+    swarm_spawn_random(&bench.swarm, count);
+    match_init(&bench.match, 1);
+
+    // One op is one step of every ball
+    char name[64];
+    snprintf(name, sizeof(name), "step/%d", count);
+    BenchResult *result = bench_run("swarm", name, bench_step, &bench, 1);
+    if (result != NULL && bench.steps > 0) {
+        result->counter_name = "contacts_per_step";
+        result->counter = (double)bench.contacts / bench.steps;
+        bench_log("%-6s %-28s %12lld candidate pairs, %lld contacts per step\n", result->suite, result->name,
+                  bench.candidates / bench.steps, bench.contacts / bench.steps);
+    }
+
+    // Only moving and finding the contacts, the part brute force would replace
+    snprintf(name, sizeof(name), "grid/%d", count);
+    bench_run("swarm", name, bench_grid_contacts, &bench, 1);
+    if (brute) {
+        snprintf(name, sizeof(name), "brute/%d", count);
+        bench_run("swarm", name, bench_brute_contacts, &bench, 1);
+    }
+
+    swarm_destroy(&bench.swarm);
+}
+
+int bench_swarm() {
+    if (!verify_swarm()) {
+        return 1;
+    }
+
+    const int counts[] = {256, 1024, 4096, SWARM_MAX_BALLS};
+    for (int i = 0; i < 4; i++) {
+        bench_count(counts[i], counts[i] <= 4096);
+    }
+    return 0;
+}
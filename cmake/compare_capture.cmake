@@ -0,0 +1,20 @@
+# Renders N frames with a fixed seed, then renders them again and compares each
+# frame with the first run, so a render() that isn't deterministic fails:
+#   cmake -DPONG=path/to/pong -DWORK_DIR=dir -DFRAMES=120 -DSEED=7 -P compare_capture.cmake
+# The second run writes on the async writer, which has to give the same frames.
+
+set(golden "${WORK_DIR}/golden.y4m")
+file(MAKE_DIRECTORY "${WORK_DIR}")
+file(REMOVE "${golden}")
+
+execute_process(COMMAND "${PONG}" --capture "${golden}" --capture-frames ${FRAMES} --seed ${SEED}
+                RESULT_VARIABLE result)
+if(NOT result EQUAL 0)
+    message(FATAL_ERROR "Capturing ${FRAMES} frames failed: ${result}")
+endif()
+
+execute_process(COMMAND "${PONG}" --compare "${golden}" --capture-frames ${FRAMES} --seed ${SEED} --capture-async
+                RESULT_VARIABLE result)
+if(NOT result EQUAL 0)
+    message(FATAL_ERROR "The second capture of ${FRAMES} frames differs from the first: ${result}")
+endif()
@@ -0,0 +1,24 @@
+# Turns a file into a C array, so the executable carries its assets with it:
+#   cmake -DINPUT=res/font.ttf -DOUTPUT=font_ttf.c -DSYMBOL=asset_font_ttf -P embed_asset.cmake
+# defines `const unsigned char asset_font_ttf[]` and `const size_t asset_font_ttf_size`.
+
+file(READ "${INPUT}" hex HEX)
+string(LENGTH "${hex}" hex_length)
+math(EXPR size "${hex_length} / 2")
+
+# 16 bytes to a line, each as 0xNN; CMake regexes have no {n}, hence the REPEAT
+string(REPEAT "[0-9a-f]" 32 line)
+string(REGEX REPLACE "(${line})" "\\1\n    " bytes "${hex}")
+string(REGEX REPLACE "([0-9a-f][0-9a-f])" "0x\\1, " bytes "${bytes}")
+string(REGEX REPLACE ", \n" ",\n" bytes "${bytes}")
+string(REGEX REPLACE "[ ,\n]+$" "," bytes "${bytes}")
+
+get_filename_component(name "${INPUT}" NAME)
+file(WRITE "${OUTPUT}.tmp"
+     "// Generated from ${name} by cmake/embed_asset.cmake; do not edit\n"
+     "#include <stddef.h>\n\n"
+     "const unsigned char ${SYMBOL}[] = {\n    ${bytes}\n};\n"
+     "const size_t ${SYMBOL}_size = ${size};\n")
+# Only touch the output when it changed, so nothing rebuilds for nothing
+file(COPY_FILE "${OUTPUT}.tmp" "${OUTPUT}" ONLY_IF_DIFFERENT)
+file(REMOVE "${OUTPUT}.tmp")
@@ -0,0 +1,98 @@
+#include "ai.h"
+
+#include <math.h>
+#include <string.h>
+
+bool parse_ai_difficulty(const char *name, AiDifficulty *difficulty) {
+    if (strcmp(name, "easy") == 0) {
+        *difficulty = AI_EASY;
+        return true;
+    }
+    if (strcmp(name, "normal") == 0) {
+        *difficulty = AI_NORMAL;
+        return true;
+    }
+    if (strcmp(name, "hard") == 0) {
+        *difficulty = AI_HARD;
+        return true;
+    }
+    return false;
+}
+
+void ai_init(AiPlayer *ai, AiDifficulty difficulty, bool is_left_side, uint64_t seed) {
+    *ai = (AiPlayer){
+        .difficulty = difficulty,
+        .is_left_side = is_left_side,
+        .rng = seed,
+        .target = SCREEN_HEIGHT / 2.0f,
+        .next_target = SCREEN_HEIGHT / 2.0f,
+    };
+}
+
+float ai_predict_y(Vector2D pos, Vector2D dir, float x) {
+    float dx = x - pos.x;
+    if (dir.x == 0 || dx * dir.x < 0) {
+        return NAN;
+    }
+
+    // Unfolded, the ball flies straight on; every wall bounce mirrors that
+    // line back into the span between the walls
+    const float span = SCREEN_HEIGHT - BALL_RADIUS;
+    float y = fmodf(pos.y + dir.y * (dx / dir.x), 2 * span);
+    if (y < 0) {
+        y += 2 * span;
+    }
+    return y > span ? 2 * span - y : y;
+}
+
+static float predict_target(const AiPlayer *ai, Vector2D ball_pos, Vector2D ball_dir, bool has_started) {
+    // The ball's near edge meets the paddle's face, as in check_collision
+    float face = ai->is_left_side ? 2 * PADDLE_WIDTH + 16 : SCREEN_WIDTH - PADDLE_WIDTH - 16 - BALL_RADIUS;
+    float y = has_started ? ai_predict_y(ball_pos, ball_dir, face) : NAN;
+    if (isnan(y)) {
+        // Not coming this way: wait in the middle
+        return SCREEN_HEIGHT / 2.0f;
+    }
+    return y + ai->aim_offset;
+}
+
+int8_t ai_steer(AiPlayer *ai, Vector2D ball_pos, Vector2D ball_dir, bool has_started, float paddle_y, float dt) {
+    if (ball_dir.x != ai->seen_dir.x || ball_dir.y != ai->seen_dir.y || has_started != ai->seen_started) {
+        // A new shot gets a new aim; a wall bounce keeps the one it has
+        bool new_shot = (ball_dir.x < 0) != (ai->seen_dir.x < 0) || has_started != ai->seen_started;
+        ai->seen_dir = ball_dir;
+        ai->seen_started = has_started;
+
+        if (new_shot) {
+            ai->aim_offset = (random_float(&ai->rng) - 0.5f) * ai->difficulty.aim_error * PADDLE_HEIGHT;
+        }
+        ai->next_target = predict_target(ai, ball_pos, ball_dir, has_started);
+        ai->predictions++;
+
+        // Already waiting to react to an earlier change counts for this one too
+        if (ai->reaction_left <= 0) {
+            ai->reaction_left = ai->difficulty.reaction_time;
+        }
+    }
+
+    ai->reaction_left -= dt;
+    if (ai->reaction_left <= 0) {
+        ai->target = ai->next_target;
+    }
+
+    float center = paddle_y + PADDLE_HEIGHT / 2.0f;
+    // Within half a step of the target, another step would only overshoot
+    float slack = PADDLE_SPEED * dt / 2;
+    if (ai->target < center - slack) {
+        return -1;
+    }
+    if (ai->target > center + slack) {
+        return 1;
+    }
+    return 0;
+}
+
+int8_t ai_input(AiPlayer *ai, const Match *match, float dt) {
+    const Paddle *paddle = ai->is_left_side ? &match->p1 : &match->p2;
+    return ai_steer(ai, match->ball.pos, match->ball.dir, match->hasStarted, paddle->pos.y, dt);
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "sim.h"
+
+// CPU opponent that works out where the ball will cross its paddle's face,
+// bounces off the top and bottom walls included, in closed form. The
+// prediction only changes when the ball's direction does (a paddle hit, a wall
+// bounce, a reset or a serve), so it is made once per change and every other
+// tick just steers towards the cached target.
+
+typedef struct {
+    // Seconds between the ball changing direction and the AI acting on it
+    float reaction_time;
+    // How far off it aims, as a fraction of the paddle height; above 1.0 it
+    // starts missing balls it could reach
+    float aim_error;
+} AiDifficulty;
+
+typedef struct {
+    AiDifficulty difficulty;
+    bool is_left_side;
+    uint64_t rng;
+
+    // What the current prediction was made from
+    Vector2D seen_dir;
+    bool seen_started;
+
+    // Drawn afresh for every shot
+    float aim_offset;
+    // Where the paddle center heads, and where it will head once it reacts
+    float target;
+    float next_target;
+    float reaction_left;
+
+    // How many times the trajectory was predicted, for the benchmarks
+    long long predictions;
+} AiPlayer;
+
+#define AI_EASY ((AiDifficulty){.reaction_time = 0.4f, .aim_error = 1.6f})
+#define AI_NORMAL ((AiDifficulty){.reaction_time = 0.25f, .aim_error = 1.3f})
+#define AI_HARD ((AiDifficulty){.reaction_time = 0.1f, .aim_error = 1.1f})
+
+bool parse_ai_difficulty(const char *name, AiDifficulty *difficulty);
+
+void ai_init(AiPlayer *ai, AiDifficulty difficulty, bool is_left_side, uint64_t seed);
+// The paddle command for this tick; O(1) unless the ball changed direction
+int8_t ai_input(AiPlayer *ai, const Match *match, float dt);
+// The same from the bare state, for callers without a Match such as the batched engine
+int8_t ai_steer(AiPlayer *ai, Vector2D ball_pos, Vector2D ball_dir, bool has_started, float paddle_y, float dt);
+
+// y the ball will have when it reaches x, folded back off the walls, or NAN if
+// it is moving away from x or straight up and down
+float ai_predict_y(Vector2D pos, Vector2D dir, float x);
@@ -0,0 +1,43 @@
+#include "assets.h"
+
+#include <stdio.h>
+
+static int decode_assets(void *data) {
+    AssetLoader *loader = data;
+    loader->decode_start = SDL_GetPerformanceCounter();
+
+    // The font is only needed until its glyphs are in the sheet
+    TTF_Font *font = TTF_OpenFontRW(SDL_RWFromConstMem(asset_font_ttf, (int)asset_font_ttf_size), 1, FONT_SIZE);
+    if (font == NULL) {
+        fprintf(stderr, "Unable to load the embedded font! SDL_ttf Error: %s\n", TTF_GetError());
+    } else {
+        loader->glyph_sheet = rasterize_glyph_atlas(&loader->atlas, font);
+        TTF_CloseFont(font);
+    }
+
+    loader->decode_end = SDL_GetPerformanceCounter();
+    return 0;
+}
+
+void start_loading_assets(AssetLoader *loader) {
+    *loader = (AssetLoader){0};
+    loader->thread = SDL_CreateThread(decode_assets, "assets", loader);
+}
+
+bool finish_loading_assets(AssetLoader *loader, SDL_Renderer *renderer, GlyphAtlas *atlas) {
+    if (loader->thread != NULL) {
+        SDL_WaitThread(loader->thread, NULL);
+        loader->thread = NULL;
+    } else {
+        decode_assets(loader);
+    }
+
+    SDL_Surface *sheet = loader->glyph_sheet;
+    loader->glyph_sheet = NULL;
+    if (sheet == NULL || renderer == NULL) {
+        SDL_FreeSurface(sheet);
+        return false;
+    }
+    *atlas = loader->atlas;
+    return upload_glyph_atlas(atlas, renderer, sheet);
+}
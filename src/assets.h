@@ -0,0 +1,34 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "glyph_atlas.h"
+
+// Assets are compiled into the executable (cmake/embed_asset.cmake), so it runs
+// from any working directory and never touches the disk to start. Decoding
+// them needs no renderer, so it runs on a thread of its own while the main
+// thread brings up the window and renderer; only the upload waits for both.
+
+#define FONT_SIZE 24
+
+extern const unsigned char asset_font_ttf[];
+extern const size_t asset_font_ttf_size;
+
+typedef struct {
+    SDL_Thread *thread;
+
+    // Written by the loading thread, read once it has been waited for
+    GlyphAtlas atlas;
+    SDL_Surface *glyph_sheet;
+    Uint64 decode_start;
+    Uint64 decode_end;
+} AssetLoader;
+
+// Call after TTF_Init. Without a thread to spare, finish_loading_assets decodes instead
+void start_loading_assets(AssetLoader *loader);
+// Waits for the decoding, then uploads what needs the renderer. With a NULL
+// renderer, e.g. when creating it failed, only waits and throws the work away
+bool finish_loading_assets(AssetLoader *loader, SDL_Renderer *renderer, GlyphAtlas *atlas);
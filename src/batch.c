@@ -0,0 +1,743 @@
+#include "batch.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define BATCH_HAS_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#if BATCH_HAS_SSE2 && defined(__GNUC__)
+#define BATCH_HAS_AVX2 1
+#include <immintrin.h>
+#define BATCH_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+// Constants exactly as update_game/move_paddles compute them
+#define P1_X ((float)(PADDLE_WIDTH + 16))
+#define P2_X ((float)(SCREEN_WIDTH - PADDLE_WIDTH - 16))
+#define PADDLE_BOTTOM ((float)(SCREEN_HEIGHT - PADDLE_HEIGHT))
+#define BALL_BOTTOM ((float)(SCREEN_HEIGHT - BALL_RADIUS))
+#define BALL_RIGHT ((float)(SCREEN_WIDTH - BALL_RADIUS))
+
+void pong_match_init(Match *match, uint64_t seed) {
+    match_init(match, seed);
+    serve_ball(match);
+}
+
+float pong_match_step(Match *match, int8_t p1_action, int8_t p2_action, float dt, bool *done) {
+    MatchInput input = {.p1 = p1_action, .p2 = p2_action, .serve = true};
+    MatchEvent event = step_match(match, input, dt, 0);
+
+    *done = false;
+    if (event == MATCH_EVENT_NONE) {
+        return 0;
+    }
+
+    if (is_match_over(match)) {
+        *done = true;
+        match->p1.score = 0;
+        match->p2.score = 0;
+    }
+    serve_ball(match);
+
+    return event == MATCH_EVENT_P1_SCORED ? 1.0f : -1.0f;
+}
+
+void pong_fixed_match_init(FixedMatch *match, uint64_t seed) {
+    fixed_match_init(match, seed);
+    fixed_serve_ball(match);
+}
+
+float pong_fixed_match_step(FixedMatch *match, int8_t p1_action, int8_t p2_action, fixed dt, bool *done) {
+    MatchInput input = {.p1 = p1_action, .p2 = p2_action, .serve = true};
+    MatchEvent event = fixed_step_match(match, input, dt, 0);
+
+    *done = false;
+    if (event == MATCH_EVENT_NONE) {
+        return 0;
+    }
+
+    if (fixed_is_match_over(match)) {
+        *done = true;
+        match->p1.score = 0;
+        match->p2.score = 0;
+    }
+    fixed_serve_ball(match);
+
+    return event == MATCH_EVENT_P1_SCORED ? 1.0f : -1.0f;
+}
+
+static void store_fixed_match(PongBatch *batch, int i, const FixedMatch *match) {
+    batch->fixed_ball_x[i] = match->ball.pos.x;
+    batch->fixed_ball_y[i] = match->ball.pos.y;
+    batch->fixed_dir_x[i] = match->ball.dir.x;
+    batch->fixed_dir_y[i] = match->ball.dir.y;
+    batch->fixed_p1_y[i] = match->p1.pos.y;
+    batch->fixed_p2_y[i] = match->p2.pos.y;
+    batch->p1_score[i] = match->p1.score;
+    batch->p2_score[i] = match->p2.score;
+    batch->rng[i] = match->rng;
+}
+
+void pong_batch_load_fixed_match(const PongBatch *batch, int i, FixedMatch *match) {
+    fixed_reset_paddles(match, false);
+    match->ball = (FixedBall){
+        .pos = {batch->fixed_ball_x[i], batch->fixed_ball_y[i]},
+        .dir = {batch->fixed_dir_x[i], batch->fixed_dir_y[i]},
+    };
+    match->p1.pos.y = batch->fixed_p1_y[i];
+    match->p2.pos.y = batch->fixed_p2_y[i];
+    match->p1.score = batch->p1_score[i];
+    match->p2.score = batch->p2_score[i];
+    match->hasStarted = true;
+    match->rng = batch->rng[i];
+}
+
+static void store_match(PongBatch *batch, int i, const Match *match) {
+    batch->ball_x[i] = match->ball.pos.x;
+    batch->ball_y[i] = match->ball.pos.y;
+    batch->dir_x[i] = match->ball.dir.x;
+    batch->dir_y[i] = match->ball.dir.y;
+    batch->p1_y[i] = match->p1.pos.y;
+    batch->p2_y[i] = match->p2.pos.y;
+    batch->p1_score[i] = match->p1.score;
+    batch->p2_score[i] = match->p2.score;
+    batch->rng[i] = match->rng;
+}
+
+void pong_batch_load_match(const PongBatch *batch, int i, Match *match) {
+    reset_paddles(match, false);
+    match->ball = (Ball){
+        .pos = {batch->ball_x[i], batch->ball_y[i]},
+        .dir = {batch->dir_x[i], batch->dir_y[i]},
+        .speed = BALL_SPEED,
+        .radius = BALL_RADIUS
+    };
+    match->p1.pos.y = batch->p1_y[i];
+    match->p2.pos.y = batch->p2_y[i];
+    match->p1.score = batch->p1_score[i];
+    match->p2.score = batch->p2_score[i];
+    match->hasStarted = true;
+    match->rng = batch->rng[i];
+}
+
+PongBatch *pong_batch_create(int count, uint64_t seed) {
+    PongBatch *batch = calloc(1, sizeof(PongBatch));
+    if (batch == NULL) {
+        return NULL;
+    }
+
+    batch->count = count;
+    batch->kernel = pong_batch_best_kernel();
+    batch->ball_x = malloc(count * sizeof(float));
+    batch->ball_y = malloc(count * sizeof(float));
+    batch->dir_x = malloc(count * sizeof(float));
+    batch->dir_y = malloc(count * sizeof(float));
+    batch->p1_y = malloc(count * sizeof(float));
+    batch->p2_y = malloc(count * sizeof(float));
+    batch->p1_score = malloc(count * sizeof(int));
+    batch->p2_score = malloc(count * sizeof(int));
+    batch->rng = malloc(count * sizeof(uint64_t));
+    batch->fixed_ball_x = malloc(count * sizeof(fixed));
+    batch->fixed_ball_y = malloc(count * sizeof(fixed));
+    batch->fixed_dir_x = malloc(count * sizeof(fixed));
+    batch->fixed_dir_y = malloc(count * sizeof(fixed));
+    batch->fixed_p1_y = malloc(count * sizeof(fixed));
+    batch->fixed_p2_y = malloc(count * sizeof(fixed));
+    batch->rewards = calloc(count, sizeof(float));
+    batch->dones = calloc(count, sizeof(uint8_t));
+
+    if (!batch->ball_x || !batch->ball_y || !batch->dir_x || !batch->dir_y || !batch->p1_y || !batch->p2_y ||
+        !batch->p1_score || !batch->p2_score || !batch->rng || !batch->fixed_ball_x || !batch->fixed_ball_y ||
+        !batch->fixed_dir_x || !batch->fixed_dir_y || !batch->fixed_p1_y || !batch->fixed_p2_y || !batch->rewards ||
+        !batch->dones) {
+        pong_batch_destroy(batch);
+        return NULL;
+    }
+
+    // Both backends start from the same seeds and draw the same RNG stream
+    for (int i = 0; i < count; i++) {
+        uint64_t match_seed = random_u64(&seed);
+        Match match;
+        pong_match_init(&match, match_seed);
+        store_match(batch, i, &match);
+
+        FixedMatch fixed_match;
+        pong_fixed_match_init(&fixed_match, match_seed);
+        store_fixed_match(batch, i, &fixed_match);
+    }
+
+    return batch;
+}
+
+void pong_batch_destroy(PongBatch *batch) {
+    if (batch == NULL) {
+        return;
+    }
+
+    free(batch->ball_x);
+    free(batch->ball_y);
+    free(batch->dir_x);
+    free(batch->dir_y);
+    free(batch->p1_y);
+    free(batch->p2_y);
+    free(batch->p1_score);
+    free(batch->p2_score);
+    free(batch->rng);
+    free(batch->fixed_ball_x);
+    free(batch->fixed_ball_y);
+    free(batch->fixed_dir_x);
+    free(batch->fixed_dir_y);
+    free(batch->fixed_p1_y);
+    free(batch->fixed_p2_y);
+    free(batch->rewards);
+    free(batch->dones);
+    free(batch);
+}
+
+// Each kernel moves the paddles and the ball of matches [start, end) and
+// writes the reward of any point scored. Scoring resets are left to
+// finish_points, since they are rare and need the RNG.
+
+static void step_scalar(PongBatch *batch, const int8_t *actions, float dt, int start, int end) {
+    const float paddle_step = PADDLE_SPEED * dt;
+    const int count = batch->count;
+
+    for (int i = start; i < end; i++) {
+        float p1_y = batch->p1_y[i];
+        float p2_y = batch->p2_y[i];
+
+        if (actions[i] < 0) p1_y -= paddle_step;
+        if (actions[i] > 0) p1_y += paddle_step;
+        if (actions[count + i] < 0) p2_y -= paddle_step;
+        if (actions[count + i] > 0) p2_y += paddle_step;
+
+        if (p1_y <= 0) p1_y += paddle_step;
+        if (p1_y >= PADDLE_BOTTOM) p1_y -= paddle_step;
+        if (p2_y <= 0) p2_y += paddle_step;
+        if (p2_y >= PADDLE_BOTTOM) p2_y -= paddle_step;
+
+        batch->p1_y[i] = p1_y;
+        batch->p2_y[i] = p2_y;
+
+        Ball ball = {
+            .pos = {batch->ball_x[i], batch->ball_y[i]},
+            .dir = {batch->dir_x[i], batch->dir_y[i]},
+            .speed = BALL_SPEED,
+            .radius = BALL_RADIUS
+        };
+        Paddle p1 = {.pos = {P1_X, p1_y}, .width = PADDLE_WIDTH, .height = PADDLE_HEIGHT};
+        Paddle p2 = {.pos = {P2_X, p2_y}, .width = PADDLE_WIDTH, .height = PADDLE_HEIGHT};
+
+        MatchEvent event = sweep_ball(&ball, &p1, &p2, dt);
+        batch->rewards[i] = event == MATCH_EVENT_P1_SCORED ? 1.0f : event == MATCH_EVENT_P2_SCORED ? -1.0f : 0;
+
+        batch->ball_x[i] = ball.pos.x;
+        batch->ball_y[i] = ball.pos.y;
+        batch->dir_x[i] = ball.dir.x;
+        batch->dir_y[i] = ball.dir.y;
+    }
+}
+
+static void step_fixed(PongBatch *batch, const int8_t *actions, fixed dt) {
+    const fixed paddle_step = PADDLE_SPEED * dt;
+    const fixed paddle_bottom = FIXED_INT(SCREEN_HEIGHT - PADDLE_HEIGHT);
+    const int count = batch->count;
+
+    for (int i = 0; i < count; i++) {
+        fixed p1_y = batch->fixed_p1_y[i];
+        fixed p2_y = batch->fixed_p2_y[i];
+
+        if (actions[i] < 0) p1_y -= paddle_step;
+        if (actions[i] > 0) p1_y += paddle_step;
+        if (actions[count + i] < 0) p2_y -= paddle_step;
+        if (actions[count + i] > 0) p2_y += paddle_step;
+
+        if (p1_y <= 0) p1_y += paddle_step;
+        if (p1_y >= paddle_bottom) p1_y -= paddle_step;
+        if (p2_y <= 0) p2_y += paddle_step;
+        if (p2_y >= paddle_bottom) p2_y -= paddle_step;
+
+        batch->fixed_p1_y[i] = p1_y;
+        batch->fixed_p2_y[i] = p2_y;
+
+        FixedBall ball = {
+            .pos = {batch->fixed_ball_x[i], batch->fixed_ball_y[i]},
+            .dir = {batch->fixed_dir_x[i], batch->fixed_dir_y[i]},
+        };
+        MatchEvent event = fixed_sweep_ball(&ball, p1_y, p2_y, dt);
+        batch->rewards[i] = event == MATCH_EVENT_P1_SCORED ? 1.0f : event == MATCH_EVENT_P2_SCORED ? -1.0f : 0;
+
+        batch->fixed_ball_x[i] = ball.pos.x;
+        batch->fixed_ball_y[i] = ball.pos.y;
+        batch->fixed_dir_x[i] = ball.dir.x;
+        batch->fixed_dir_y[i] = ball.dir.y;
+    }
+}
+
+// The SIMD kernels run sweep_ball's loop on every lane at once, op for op,
+// with masks standing in for its branches. Lanes drop out once their step is
+// used up or they score, and the loop ends when none are left.
+
+#if BATCH_HAS_SSE2
+
+static inline __m128 select_ps(__m128 mask, __m128 a, __m128 b) {
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+static inline __m128i load_actions_sse2(const int8_t *actions) {
+    int32_t packed;
+    memcpy(&packed, actions, sizeof(packed));
+    __m128i v = _mm_cvtsi32_si128(packed);
+    v = _mm_unpacklo_epi8(v, v);
+    v = _mm_unpacklo_epi16(v, v);
+    return _mm_srai_epi32(v, 24);
+}
+
+// reflect_vec(dir, normal) with normal = (nx, 0), spelled out op for op
+static inline void reflect_x_sse2(__m128 *dx, __m128 *dy, __m128 nx) {
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 two = _mm_set1_ps(2.0f);
+    __m128 dot = _mm_add_ps(_mm_mul_ps(*dx, nx), _mm_mul_ps(*dy, zero));
+    __m128 two_dot = _mm_mul_ps(two, dot);
+    *dx = _mm_sub_ps(*dx, _mm_mul_ps(two_dot, nx));
+    *dy = _mm_sub_ps(*dy, _mm_mul_ps(two_dot, zero));
+}
+
+// Picks t where it beats the best so far, like sweep_ball's strict < scan
+static inline void pick_contact_sse2(__m128 t, float contact, __m128 *best, __m128 *best_contact) {
+    __m128 closer = _mm_cmplt_ps(t, *best);
+    *best = select_ps(closer, t, *best);
+    *best_contact = select_ps(closer, _mm_set1_ps(contact), *best_contact);
+}
+
+static int step_sse2(PongBatch *batch, const int8_t *actions, float dt) {
+    const int count = batch->count;
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 inf = _mm_set1_ps(INFINITY);
+    const __m128 paddle_step = _mm_set1_ps(PADDLE_SPEED * dt);
+    const __m128 ball_speed = _mm_set1_ps(BALL_SPEED);
+    const __m128 paddle_bottom = _mm_set1_ps(PADDLE_BOTTOM);
+    const __m128 ball_bottom = _mm_set1_ps(BALL_BOTTOM);
+    const __m128 ball_right = _mm_set1_ps(BALL_RIGHT);
+    const __m128 radius = _mm_set1_ps(BALL_RADIUS);
+    const __m128 paddle_height = _mm_set1_ps(PADDLE_HEIGHT);
+    const __m128 p1_left = _mm_set1_ps(P1_X);
+    const __m128 p1_right = _mm_set1_ps(P1_X + PADDLE_WIDTH);
+    const __m128 p2_left = _mm_set1_ps(P2_X);
+    const __m128 p2_right = _mm_set1_ps(P2_X + PADDLE_WIDTH);
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 minus_one = _mm_set1_ps(-1.0f);
+    const __m128 sign = _mm_set1_ps(-0.0f);
+
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i a1 = load_actions_sse2(actions + i);
+        __m128i a2 = load_actions_sse2(actions + count + i);
+        __m128 p1_y = _mm_loadu_ps(batch->p1_y + i);
+        __m128 p2_y = _mm_loadu_ps(batch->p2_y + i);
+
+        p1_y = select_ps(_mm_castsi128_ps(_mm_cmplt_epi32(a1, _mm_setzero_si128())), _mm_sub_ps(p1_y, paddle_step), p1_y);
+        p1_y = select_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(a1, _mm_setzero_si128())), _mm_add_ps(p1_y, paddle_step), p1_y);
+        p2_y = select_ps(_mm_castsi128_ps(_mm_cmplt_epi32(a2, _mm_setzero_si128())), _mm_sub_ps(p2_y, paddle_step), p2_y);
+        p2_y = select_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(a2, _mm_setzero_si128())), _mm_add_ps(p2_y, paddle_step), p2_y);
+
+        p1_y = select_ps(_mm_cmple_ps(p1_y, zero), _mm_add_ps(p1_y, paddle_step), p1_y);
+        p1_y = select_ps(_mm_cmpge_ps(p1_y, paddle_bottom), _mm_sub_ps(p1_y, paddle_step), p1_y);
+        p2_y = select_ps(_mm_cmple_ps(p2_y, zero), _mm_add_ps(p2_y, paddle_step), p2_y);
+        p2_y = select_ps(_mm_cmpge_ps(p2_y, paddle_bottom), _mm_sub_ps(p2_y, paddle_step), p2_y);
+
+        _mm_storeu_ps(batch->p1_y + i, p1_y);
+        _mm_storeu_ps(batch->p2_y + i, p2_y);
+
+        __m128 x = _mm_loadu_ps(batch->ball_x + i);
+        __m128 y = _mm_loadu_ps(batch->ball_y + i);
+        __m128 dx = _mm_loadu_ps(batch->dir_x + i);
+        __m128 dy = _mm_loadu_ps(batch->dir_y + i);
+        __m128 p1_end = _mm_add_ps(p1_y, paddle_height);
+        __m128 p2_end = _mm_add_ps(p2_y, paddle_height);
+
+        __m128 remaining = _mm_set1_ps(dt);
+        __m128 active = _mm_cmpeq_ps(zero, zero);
+        __m128 reward = zero;
+
+        for (int bounce = 0; bounce < MAX_BOUNCES && _mm_movemask_ps(active); bounce++) {
+            __m128 vx = _mm_mul_ps(dx, ball_speed);
+            __m128 vy = _mm_mul_ps(dy, ball_speed);
+            __m128 left_moving = _mm_cmplt_ps(vx, zero);
+            __m128 right_moving = _mm_cmpgt_ps(vx, zero);
+
+            __m128 t = _mm_max_ps(_mm_div_ps(_mm_sub_ps(p1_right, x), vx), zero);
+            __m128 hit_y = _mm_add_ps(y, _mm_mul_ps(vy, t));
+            __m128 hit = _mm_and_ps(_mm_and_ps(left_moving, _mm_cmpge_ps(x, p1_left)),
+                                    _mm_and_ps(_mm_cmpge_ps(hit_y, p1_y), _mm_cmple_ps(hit_y, p1_end)));
+            __m128 best = select_ps(hit, t, inf);
+            __m128 contact = _mm_set1_ps(CONTACT_P1);
+
+            __m128 right_edge = _mm_add_ps(x, radius);
+            t = _mm_max_ps(_mm_div_ps(_mm_sub_ps(p2_left, right_edge), vx), zero);
+            hit_y = _mm_add_ps(y, _mm_mul_ps(vy, t));
+            hit = _mm_and_ps(_mm_and_ps(right_moving, _mm_cmple_ps(right_edge, p2_right)),
+                             _mm_and_ps(_mm_cmpge_ps(hit_y, p2_y), _mm_cmple_ps(hit_y, p2_end)));
+            pick_contact_sse2(select_ps(hit, t, inf), CONTACT_P2, &best, &contact);
+
+            t = _mm_max_ps(_mm_div_ps(_mm_sub_ps(zero, y), vy), zero);
+            pick_contact_sse2(select_ps(_mm_cmplt_ps(vy, zero), t, inf), CONTACT_TOP, &best, &contact);
+            t = _mm_max_ps(_mm_div_ps(_mm_sub_ps(ball_bottom, y), vy), zero);
+            pick_contact_sse2(select_ps(_mm_cmpgt_ps(vy, zero), t, inf), CONTACT_BOTTOM, &best, &contact);
+            t = _mm_max_ps(_mm_div_ps(_mm_sub_ps(zero, x), vx), zero);
+            pick_contact_sse2(select_ps(left_moving, t, inf), CONTACT_LEFT, &best, &contact);
+            t = _mm_max_ps(_mm_div_ps(_mm_sub_ps(ball_right, x), vx), zero);
+            pick_contact_sse2(select_ps(right_moving, t, inf), CONTACT_RIGHT, &best, &contact);
+
+            __m128 touches = _mm_and_ps(active, _mm_cmple_ps(best, remaining));
+            __m128 step = select_ps(touches, best, remaining);
+            x = select_ps(active, _mm_add_ps(x, _mm_mul_ps(vx, step)), x);
+            y = select_ps(active, _mm_add_ps(y, _mm_mul_ps(vy, step)), y);
+            remaining = select_ps(touches, _mm_sub_ps(remaining, best), remaining);
+
+            __m128 rdx = dx, rdy = dy;
+            reflect_x_sse2(&rdx, &rdy, one);
+            __m128 on = _mm_and_ps(touches, _mm_cmpeq_ps(contact, _mm_set1_ps(CONTACT_P1)));
+            dx = select_ps(on, rdx, dx);
+            dy = select_ps(on, rdy, dy);
+
+            rdx = dx, rdy = dy;
+            reflect_x_sse2(&rdx, &rdy, minus_one);
+            on = _mm_and_ps(touches, _mm_cmpeq_ps(contact, _mm_set1_ps(CONTACT_P2)));
+            dx = select_ps(on, rdx, dx);
+            dy = select_ps(on, rdy, dy);
+
+            on = _mm_and_ps(touches, _mm_or_ps(_mm_cmpeq_ps(contact, _mm_set1_ps(CONTACT_TOP)),
+                                               _mm_cmpeq_ps(contact, _mm_set1_ps(CONTACT_BOTTOM))));
+            dy = _mm_xor_ps(dy, _mm_and_ps(on, sign));
+
+            __m128 p2_scored = _mm_and_ps(touches, _mm_cmpeq_ps(contact, _mm_set1_ps(CONTACT_LEFT)));
+            __m128 p1_scored = _mm_and_ps(touches, _mm_cmpeq_ps(contact, _mm_set1_ps(CONTACT_RIGHT)));
+            reward = _mm_or_ps(reward, _mm_or_ps(_mm_and_ps(p1_scored, one), _mm_and_ps(p2_scored, minus_one)));
+
+            active = _mm_andnot_ps(_mm_or_ps(p1_scored, p2_scored), touches);
+        }
+
+        _mm_storeu_ps(batch->rewards + i, reward);
+        _mm_storeu_ps(batch->ball_x + i, x);
+        _mm_storeu_ps(batch->ball_y + i, y);
+        _mm_storeu_ps(batch->dir_x + i, dx);
+        _mm_storeu_ps(batch->dir_y + i, dy);
+    }
+
+    return i;
+}
+
+#endif
+
+#if BATCH_HAS_AVX2
+
+static inline BATCH_TARGET_AVX2 __m256 load_actions_avx2(const int8_t *actions) {
+    __m128i packed = _mm_loadl_epi64((const __m128i *)actions);
+    return _mm256_cvtepi32_ps(_mm256_cvtepi8_epi32(packed));
+}
+
+static inline BATCH_TARGET_AVX2 void reflect_x_avx2(__m256 *dx, __m256 *dy, __m256 nx) {
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 two = _mm256_set1_ps(2.0f);
+    __m256 dot = _mm256_add_ps(_mm256_mul_ps(*dx, nx), _mm256_mul_ps(*dy, zero));
+    __m256 two_dot = _mm256_mul_ps(two, dot);
+    *dx = _mm256_sub_ps(*dx, _mm256_mul_ps(two_dot, nx));
+    *dy = _mm256_sub_ps(*dy, _mm256_mul_ps(two_dot, zero));
+}
+
+static inline BATCH_TARGET_AVX2 void pick_contact_avx2(__m256 t, float contact, __m256 *best, __m256 *best_contact) {
+    __m256 closer = _mm256_cmp_ps(t, *best, _CMP_LT_OQ);
+    *best = _mm256_blendv_ps(*best, t, closer);
+    *best_contact = _mm256_blendv_ps(*best_contact, _mm256_set1_ps(contact), closer);
+}
+
+static BATCH_TARGET_AVX2 int step_avx2(PongBatch *batch, const int8_t *actions, float dt) {
+    const int count = batch->count;
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 inf = _mm256_set1_ps(INFINITY);
+    const __m256 paddle_step = _mm256_set1_ps(PADDLE_SPEED * dt);
+    const __m256 ball_speed = _mm256_set1_ps(BALL_SPEED);
+    const __m256 paddle_bottom = _mm256_set1_ps(PADDLE_BOTTOM);
+    const __m256 ball_bottom = _mm256_set1_ps(BALL_BOTTOM);
+    const __m256 ball_right = _mm256_set1_ps(BALL_RIGHT);
+    const __m256 radius = _mm256_set1_ps(BALL_RADIUS);
+    const __m256 paddle_height = _mm256_set1_ps(PADDLE_HEIGHT);
+    const __m256 p1_left = _mm256_set1_ps(P1_X);
+    const __m256 p1_right = _mm256_set1_ps(P1_X + PADDLE_WIDTH);
+    const __m256 p2_left = _mm256_set1_ps(P2_X);
+    const __m256 p2_right = _mm256_set1_ps(P2_X + PADDLE_WIDTH);
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 minus_one = _mm256_set1_ps(-1.0f);
+    const __m256 sign = _mm256_set1_ps(-0.0f);
+
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 a1 = load_actions_avx2(actions + i);
+        __m256 a2 = load_actions_avx2(actions + count + i);
+        __m256 p1_y = _mm256_loadu_ps(batch->p1_y + i);
+        __m256 p2_y = _mm256_loadu_ps(batch->p2_y + i);
+
+        p1_y = _mm256_blendv_ps(p1_y, _mm256_sub_ps(p1_y, paddle_step), _mm256_cmp_ps(a1, zero, _CMP_LT_OQ));
+        p1_y = _mm256_blendv_ps(p1_y, _mm256_add_ps(p1_y, paddle_step), _mm256_cmp_ps(a1, zero, _CMP_GT_OQ));
+        p2_y = _mm256_blendv_ps(p2_y, _mm256_sub_ps(p2_y, paddle_step), _mm256_cmp_ps(a2, zero, _CMP_LT_OQ));
+        p2_y = _mm256_blendv_ps(p2_y, _mm256_add_ps(p2_y, paddle_step), _mm256_cmp_ps(a2, zero, _CMP_GT_OQ));
+
+        p1_y = _mm256_blendv_ps(p1_y, _mm256_add_ps(p1_y, paddle_step), _mm256_cmp_ps(p1_y, zero, _CMP_LE_OQ));
+        p1_y = _mm256_blendv_ps(p1_y, _mm256_sub_ps(p1_y, paddle_step), _mm256_cmp_ps(p1_y, paddle_bottom, _CMP_GE_OQ));
+        p2_y = _mm256_blendv_ps(p2_y, _mm256_add_ps(p2_y, paddle_step), _mm256_cmp_ps(p2_y, zero, _CMP_LE_OQ));
+        p2_y = _mm256_blendv_ps(p2_y, _mm256_sub_ps(p2_y, paddle_step), _mm256_cmp_ps(p2_y, paddle_bottom, _CMP_GE_OQ));
+
+        _mm256_storeu_ps(batch->p1_y + i, p1_y);
+        _mm256_storeu_ps(batch->p2_y + i, p2_y);
+
+        __m256 x = _mm256_loadu_ps(batch->ball_x + i);
+        __m256 y = _mm256_loadu_ps(batch->ball_y + i);
+        __m256 dx = _mm256_loadu_ps(batch->dir_x + i);
+        __m256 dy = _mm256_loadu_ps(batch->dir_y + i);
+        __m256 p1_end = _mm256_add_ps(p1_y, paddle_height);
+        __m256 p2_end = _mm256_add_ps(p2_y, paddle_height);
+
+        __m256 remaining = _mm256_set1_ps(dt);
+        __m256 active = _mm256_cmp_ps(zero, zero, _CMP_EQ_OQ);
+        __m256 reward = zero;
+
+        for (int bounce = 0; bounce < MAX_BOUNCES && _mm256_movemask_ps(active); bounce++) {
+            __m256 vx = _mm256_mul_ps(dx, ball_speed);
+            __m256 vy = _mm256_mul_ps(dy, ball_speed);
+            __m256 left_moving = _mm256_cmp_ps(vx, zero, _CMP_LT_OQ);
+            __m256 right_moving = _mm256_cmp_ps(vx, zero, _CMP_GT_OQ);
+
+            __m256 t = _mm256_max_ps(_mm256_div_ps(_mm256_sub_ps(p1_right, x), vx), zero);
+            __m256 hit_y = _mm256_add_ps(y, _mm256_mul_ps(vy, t));
+            __m256 hit = _mm256_and_ps(
+                _mm256_and_ps(left_moving, _mm256_cmp_ps(x, p1_left, _CMP_GE_OQ)),
+                _mm256_and_ps(_mm256_cmp_ps(hit_y, p1_y, _CMP_GE_OQ), _mm256_cmp_ps(hit_y, p1_end, _CMP_LE_OQ)));
+            __m256 best = _mm256_blendv_ps(inf, t, hit);
+            __m256 contact = _mm256_set1_ps(CONTACT_P1);
+
+            __m256 right_edge = _mm256_add_ps(x, radius);
+            t = _mm256_max_ps(_mm256_div_ps(_mm256_sub_ps(p2_left, right_edge), vx), zero);
+            hit_y = _mm256_add_ps(y, _mm256_mul_ps(vy, t));
+            hit = _mm256_and_ps(
+                _mm256_and_ps(right_moving, _mm256_cmp_ps(right_edge, p2_right, _CMP_LE_OQ)),
+                _mm256_and_ps(_mm256_cmp_ps(hit_y, p2_y, _CMP_GE_OQ), _mm256_cmp_ps(hit_y, p2_end, _CMP_LE_OQ)));
+            pick_contact_avx2(_mm256_blendv_ps(inf, t, hit), CONTACT_P2, &best, &contact);
+
+            t = _mm256_max_ps(_mm256_div_ps(_mm256_sub_ps(zero, y), vy), zero);
+            pick_contact_avx2(_mm256_blendv_ps(inf, t, _mm256_cmp_ps(vy, zero, _CMP_LT_OQ)), CONTACT_TOP, &best, &contact);
+            t = _mm256_max_ps(_mm256_div_ps(_mm256_sub_ps(ball_bottom, y), vy), zero);
+            pick_contact_avx2(_mm256_blendv_ps(inf, t, _mm256_cmp_ps(vy, zero, _CMP_GT_OQ)), CONTACT_BOTTOM, &best, &contact);
+            t = _mm256_max_ps(_mm256_div_ps(_mm256_sub_ps(zero, x), vx), zero);
+            pick_contact_avx2(_mm256_blendv_ps(inf, t, left_moving), CONTACT_LEFT, &best, &contact);
+            t = _mm256_max_ps(_mm256_div_ps(_mm256_sub_ps(ball_right, x), vx), zero);
+            pick_contact_avx2(_mm256_blendv_ps(inf, t, right_moving), CONTACT_RIGHT, &best, &contact);
+
+            __m256 touches = _mm256_and_ps(active, _mm256_cmp_ps(best, remaining, _CMP_LE_OQ));
+            __m256 step = _mm256_blendv_ps(remaining, best, touches);
+            x = _mm256_blendv_ps(x, _mm256_add_ps(x, _mm256_mul_ps(vx, step)), active);
+            y = _mm256_blendv_ps(y, _mm256_add_ps(y, _mm256_mul_ps(vy, step)), active);
+            remaining = _mm256_blendv_ps(remaining, _mm256_sub_ps(remaining, best), touches);
+
+            __m256 rdx = dx, rdy = dy;
+            reflect_x_avx2(&rdx, &rdy, one);
+            __m256 on = _mm256_and_ps(touches, _mm256_cmp_ps(contact, _mm256_set1_ps(CONTACT_P1), _CMP_EQ_OQ));
+            dx = _mm256_blendv_ps(dx, rdx, on);
+            dy = _mm256_blendv_ps(dy, rdy, on);
+
+            rdx = dx, rdy = dy;
+            reflect_x_avx2(&rdx, &rdy, minus_one);
+            on = _mm256_and_ps(touches, _mm256_cmp_ps(contact, _mm256_set1_ps(CONTACT_P2), _CMP_EQ_OQ));
+            dx = _mm256_blendv_ps(dx, rdx, on);
+            dy = _mm256_blendv_ps(dy, rdy, on);
+
+            on = _mm256_and_ps(touches, _mm256_or_ps(_mm256_cmp_ps(contact, _mm256_set1_ps(CONTACT_TOP), _CMP_EQ_OQ),
+                                                     _mm256_cmp_ps(contact, _mm256_set1_ps(CONTACT_BOTTOM), _CMP_EQ_OQ)));
+            dy = _mm256_xor_ps(dy, _mm256_and_ps(on, sign));
+
+            __m256 p2_scored = _mm256_and_ps(touches, _mm256_cmp_ps(contact, _mm256_set1_ps(CONTACT_LEFT), _CMP_EQ_OQ));
+            __m256 p1_scored = _mm256_and_ps(touches, _mm256_cmp_ps(contact, _mm256_set1_ps(CONTACT_RIGHT), _CMP_EQ_OQ));
+            reward = _mm256_or_ps(reward, _mm256_or_ps(_mm256_and_ps(p1_scored, one), _mm256_and_ps(p2_scored, minus_one)));
+
+            active = _mm256_andnot_ps(_mm256_or_ps(p1_scored, p2_scored), touches);
+        }
+
+        _mm256_storeu_ps(batch->rewards + i, reward);
+        _mm256_storeu_ps(batch->ball_x + i, x);
+        _mm256_storeu_ps(batch->ball_y + i, y);
+        _mm256_storeu_ps(batch->dir_x + i, dx);
+        _mm256_storeu_ps(batch->dir_y + i, dy);
+    }
+
+    return i;
+}
+
+#endif
+
+static int finish_fixed_points(PongBatch *batch) {
+    int finished = 0;
+
+    memset(batch->dones, 0, batch->count);
+    for (int i = 0; i < batch->count; i++) {
+        if (batch->rewards[i] == 0) {
+            continue;
+        }
+
+        FixedMatch match;
+        pong_batch_load_fixed_match(batch, i, &match);
+        if (batch->rewards[i] > 0) {
+            match.p1.score++;
+        } else {
+            match.p2.score++;
+        }
+        fixed_reset_paddles(&match, true);
+        fixed_reset_ball(&match);
+
+        if (fixed_is_match_over(&match)) {
+            batch->dones[i] = 1;
+            finished++;
+            match.p1.score = 0;
+            match.p2.score = 0;
+        }
+        fixed_serve_ball(&match);
+
+        store_fixed_match(batch, i, &match);
+    }
+
+    return finished;
+}
+
+static int finish_points(PongBatch *batch) {
+    int finished = 0;
+
+    memset(batch->dones, 0, batch->count);
+    for (int i = 0; i < batch->count; i++) {
+        if (batch->rewards[i] == 0) {
+            continue;
+        }
+
+        Match match;
+        pong_batch_load_match(batch, i, &match);
+        if (batch->rewards[i] > 0) {
+            match.p1.score++;
+        } else {
+            match.p2.score++;
+        }
+        reset_paddles(&match, true);
+        reset_ball(&match);
+
+        if (is_match_over(&match)) {
+            batch->dones[i] = 1;
+            finished++;
+            match.p1.score = 0;
+            match.p2.score = 0;
+        }
+        serve_ball(&match);
+
+        store_match(batch, i, &match);
+    }
+
+    return finished;
+}
+
+int pong_batch_step(PongBatch *batch, const int8_t *actions, float dt) {
+    int vectorized = 0;
+
+    if (batch->kernel == BATCH_KERNEL_FIXED) {
+        step_fixed(batch, actions, fixed_from_float(dt));
+        return finish_fixed_points(batch);
+    }
+
+    switch (batch->kernel) {
+#if BATCH_HAS_AVX2
+        case BATCH_KERNEL_AVX2:
+            vectorized = step_avx2(batch, actions, dt);
+            break;
+#endif
+#if BATCH_HAS_SSE2
+        case BATCH_KERNEL_SSE2:
+            vectorized = step_sse2(batch, actions, dt);
+            break;
+#endif
+        default:
+            break;
+    }
+
+    // Whatever doesn't fill a whole vector
+    step_scalar(batch, actions, dt, vectorized, batch->count);
+
+    return finish_points(batch);
+}
+
+void pong_batch_ai_actions(const PongBatch *batch, AiPlayer *players, int8_t *actions, float dt) {
+    const int n = batch->count;
+    const bool is_fixed = batch->kernel == BATCH_KERNEL_FIXED;
+
+    for (int i = 0; i < n; i++) {
+        Vector2D pos = {batch->ball_x[i], batch->ball_y[i]};
+        Vector2D dir = {batch->dir_x[i], batch->dir_y[i]};
+        float p1_y = batch->p1_y[i];
+        float p2_y = batch->p2_y[i];
+        if (is_fixed) {
+            pos = (Vector2D){fixed_to_float(batch->fixed_ball_x[i]), fixed_to_float(batch->fixed_ball_y[i])};
+            dir = (Vector2D){fixed_to_float(batch->fixed_dir_x[i]), fixed_to_float(batch->fixed_dir_y[i])};
+            p1_y = fixed_to_float(batch->fixed_p1_y[i]);
+            p2_y = fixed_to_float(batch->fixed_p2_y[i]);
+        }
+
+        // Batched matches are always in play
+        actions[i] = ai_steer(&players[i], pos, dir, true, p1_y, dt);
+        actions[n + i] = ai_steer(&players[n + i], pos, dir, true, p2_y, dt);
+    }
+}
+
+bool pong_batch_kernel_supported(BatchKernel kernel) {
+    switch (kernel) {
+        case BATCH_KERNEL_SCALAR:
+        case BATCH_KERNEL_FIXED:
+            return true;
+#if BATCH_HAS_SSE2
+        case BATCH_KERNEL_SSE2:
+            return true;
+#endif
+#if BATCH_HAS_AVX2
+        case BATCH_KERNEL_AVX2:
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx2");
+#endif
+        default:
+            return false;
+    }
+}
+
+BatchKernel pong_batch_best_kernel() {
+#ifdef PONG_FIXED_POINT
+    return BATCH_KERNEL_FIXED;
+#else
+    if (pong_batch_kernel_supported(BATCH_KERNEL_AVX2)) {
+        return BATCH_KERNEL_AVX2;
+    }
+    if (pong_batch_kernel_supported(BATCH_KERNEL_SSE2)) {
+        return BATCH_KERNEL_SSE2;
+    }
+    return BATCH_KERNEL_SCALAR;
+#endif
+}
+
+const char *pong_batch_kernel_name(BatchKernel kernel) {
+    switch (kernel) {
+        case BATCH_KERNEL_SCALAR:
+            return "scalar";
+        case BATCH_KERNEL_SSE2:
+            return "sse2";
+        case BATCH_KERNEL_AVX2:
+            return "avx2";
+        case BATCH_KERNEL_FIXED:
+            return "fixed";
+    }
+    return "unknown";
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "ai.h"
+#include "sim.h"
+#include "sim_fixed.h"
+
+// Batched engine: steps many independent matches in lockstep. State is kept
+// as struct-of-arrays so the hot loop runs SIMD-wide over matches. Matches are
+// always in play: a point is served again straight away and a finished match
+// starts over at 0 : 0.
+
+typedef enum {
+    BATCH_KERNEL_SCALAR,
+    BATCH_KERNEL_SSE2,
+    BATCH_KERNEL_AVX2,
+    // Integer-only, on the Q16.16 backend in sim_fixed.h
+    BATCH_KERNEL_FIXED,
+} BatchKernel;
+
+typedef struct {
+    int count;
+    BatchKernel kernel;
+
+    float *ball_x;
+    float *ball_y;
+    float *dir_x;
+    float *dir_y;
+    float *p1_y;
+    float *p2_y;
+    int *p1_score;
+    int *p2_score;
+    uint64_t *rng;
+
+    // Positions for the fixed kernel, which steps these instead of the float
+    // arrays; pick the kernel before the first step
+    fixed *fixed_ball_x;
+    fixed *fixed_ball_y;
+    fixed *fixed_dir_x;
+    fixed *fixed_dir_y;
+    fixed *fixed_p1_y;
+    fixed *fixed_p2_y;
+
+    // Outputs of the last pong_batch_step: +1 when p1 scored, -1 when p2
+    // scored, and 1 in dones when that point ended the match.
+    float *rewards;
+    uint8_t *dones;
+} PongBatch;
+
+PongBatch *pong_batch_create(int count, uint64_t seed);
+void pong_batch_destroy(PongBatch *batch);
+
+// actions holds 2 * count paddle commands (-1, 0, 1): p1 of every match
+// first, then p2 of every match. Returns the number of matches that ended.
+int pong_batch_step(PongBatch *batch, const int8_t *actions, float dt);
+
+// Fills actions from 2 * count AI players laid out the same way, p1 of every
+// match first; each player sees only its own match
+void pong_batch_ai_actions(const PongBatch *batch, AiPlayer *players, int8_t *actions, float dt);
+
+bool pong_batch_kernel_supported(BatchKernel kernel);
+BatchKernel pong_batch_best_kernel();
+const char *pong_batch_kernel_name(BatchKernel kernel);
+
+// Scalar reference with the batch's semantics, built on step_match. A lane of
+// the batch matches a Match driven by these bit for bit.
+void pong_match_init(Match *match, uint64_t seed);
+float pong_match_step(Match *match, int8_t p1_action, int8_t p2_action, float dt, bool *done);
+void pong_batch_load_match(const PongBatch *batch, int index, Match *match);
+
+// The same for the fixed kernel, built on fixed_step_match
+void pong_fixed_match_init(FixedMatch *match, uint64_t seed);
+float pong_fixed_match_step(FixedMatch *match, int8_t p1_action, int8_t p2_action, fixed dt, bool *done);
+void pong_batch_load_fixed_match(const PongBatch *batch, int index, FixedMatch *match);
@@ -0,0 +1,278 @@
+#include "capture.h"
+
+#include "sim.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+#define Y4M_FRAME_HEADER "FRAME\n"
+#define Y4M_FRAME_HEADER_SIZE (sizeof(Y4M_FRAME_HEADER) - 1)
+
+bool parse_capture_format(const char *name, CaptureFormat *format) {
+    if (strcmp(name, "y4m") == 0) {
+        *format = CAPTURE_Y4M;
+        return true;
+    }
+    if (strcmp(name, "rgba") == 0) {
+        *format = CAPTURE_RGBA;
+        return true;
+    }
+    return false;
+}
+
+static int luma(int r, int g, int b) {
+    return ((66 * r + 129 * g + 25 * b + 128) >> 8) + 16;
+}
+
+// From the sums of a 2x2 block; biased so the shift never sees a negative number
+static int chroma(int r, int g, int b, int kr, int kg, int kb) {
+    return (kr * r + kg * g + kb * b + (128 << 10) + 512) >> 10;
+}
+
+static void pack_y4m(const SDL_Surface *surface, uint8_t *out) {
+    const int w = surface->w;
+    const int h = surface->h;
+    memcpy(out, Y4M_FRAME_HEADER, Y4M_FRAME_HEADER_SIZE);
+    uint8_t *y_plane = out + Y4M_FRAME_HEADER_SIZE;
+    uint8_t *u_plane = y_plane + w * h;
+    uint8_t *v_plane = u_plane + (w / 2) * (h / 2);
+
+    for (int row = 0; row < h; row += 2) {
+        const uint8_t *top = (const uint8_t *)surface->pixels + row * surface->pitch;
+        const uint8_t *bottom = top + surface->pitch;
+        uint8_t *y_top = y_plane + row * w;
+        uint8_t *y_bottom = y_top + w;
+
+        for (int column = 0; column < w; column += 2) {
+            const uint8_t *p[4] = {top + 4 * column, top + 4 * column + 4, bottom + 4 * column,
+                                   bottom + 4 * column + 4};
+            y_top[column] = (uint8_t)luma(p[0][0], p[0][1], p[0][2]);
+            y_top[column + 1] = (uint8_t)luma(p[1][0], p[1][1], p[1][2]);
+            y_bottom[column] = (uint8_t)luma(p[2][0], p[2][1], p[2][2]);
+            y_bottom[column + 1] = (uint8_t)luma(p[3][0], p[3][1], p[3][2]);
+
+            int r = p[0][0] + p[1][0] + p[2][0] + p[3][0];
+            int g = p[0][1] + p[1][1] + p[2][1] + p[3][1];
+            int b = p[0][2] + p[1][2] + p[2][2] + p[3][2];
+            int chroma_index = (row / 2) * (w / 2) + column / 2;
+            u_plane[chroma_index] = (uint8_t)chroma(r, g, b, -38, -74, 112);
+            v_plane[chroma_index] = (uint8_t)chroma(r, g, b, 112, -94, -18);
+        }
+    }
+}
+
+// The frame as it goes out: packed into out, or the surface itself when that
+// already is the frame and nothing else will draw into it before it's written
+static const uint8_t *pack_frame(FrameCapture *capture, uint8_t *out) {
+    const SDL_Surface *surface = capture->surface;
+    const size_t row_size = 4 * (size_t)surface->w;
+
+    if (capture->format == CAPTURE_Y4M) {
+        pack_y4m(surface, out);
+        return out;
+    }
+    if (!capture->isAsync && surface->pitch == (int)row_size) {
+        return surface->pixels;
+    }
+    for (int row = 0; row < surface->h; row++) {
+        memcpy(out + row * row_size, (const uint8_t *)surface->pixels + row * surface->pitch, row_size);
+    }
+    return out;
+}
+
+// Writes the frame and checks it against the golden one, on whichever thread writes
+static void consume_frame(FrameCapture *capture, const uint8_t *frame, long long index) {
+    const Uint64 start = SDL_GetPerformanceCounter();
+    const size_t size = capture->frame_size;
+
+    if (capture->file != NULL && fwrite(frame, 1, size, capture->file) != size) {
+        fprintf(stderr, "Unable to write frame %lld of the capture\n", index);
+        atomic_store(&capture->hasFailed, true);
+    }
+    if (capture->golden != NULL) {
+        bool same = fread(capture->golden_frame, 1, size, capture->golden) == size &&
+                    memcmp(capture->golden_frame, frame, size) == 0;
+        if (!same && capture->mismatched_frames++ == 0) {
+            capture->first_mismatch = index;
+        }
+    }
+    capture->write_counts += SDL_GetPerformanceCounter() - start;
+}
+
+static int writer_thread(void *data) {
+    FrameCapture *capture = data;
+
+    for (int slot = 0;; slot = (slot + 1) % CAPTURE_SLOTS) {
+        SDL_SemWait(capture->ready_slots);
+        // A slot without a frame is the signal to stop
+        if (capture->slot_frames[slot] < 0) {
+            return 0;
+        }
+        consume_frame(capture, capture->slots[slot], capture->slot_frames[slot]);
+        SDL_SemPost(capture->free_slots);
+    }
+}
+
+bool capture_open(FrameCapture *capture, const char *path, const char *golden_path, CaptureFormat format,
+                  int frame_rate, bool async) {
+    *capture = (FrameCapture){.format = format, .first_mismatch = -1, .isAsync = async};
+    atomic_init(&capture->hasFailed, false);
+
+    // RGBA32 is R, G, B, A in memory whatever the byte order, so raw frames are the pixels as they are
+    capture->surface = SDL_CreateRGBSurfaceWithFormat(0, SCREEN_WIDTH, SCREEN_HEIGHT, 32, SDL_PIXELFORMAT_RGBA32);
+    if (capture->surface == NULL) {
+        fprintf(stderr, "Unable to create the capture surface! SDL Error: %s\n", SDL_GetError());
+        return false;
+    }
+
+    const size_t pixels = (size_t)SCREEN_WIDTH * SCREEN_HEIGHT;
+    capture->frame_size = format == CAPTURE_Y4M ? Y4M_FRAME_HEADER_SIZE + pixels * 3 / 2 : pixels * 4;
+    for (int i = 0; i < (async ? CAPTURE_SLOTS : 1); i++) {
+        capture->slots[i] = malloc(capture->frame_size);
+        if (capture->slots[i] == NULL) {
+            fprintf(stderr, "Out of memory for capture frames\n");
+            capture_destroy(capture);
+            return false;
+        }
+    }
+
+    char header[128] = "";
+    if (format == CAPTURE_Y4M) {
+        snprintf(header, sizeof(header), "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg\n", SCREEN_WIDTH, SCREEN_HEIGHT,
+                 frame_rate);
+    }
+    const size_t header_size = strlen(header);
+
+    if (path != NULL && strcmp(path, "-") == 0) {
+#ifdef _WIN32
+        _setmode(_fileno(stdout), _O_BINARY);
+#endif
+        capture->file = stdout;
+    } else if (path != NULL) {
+        capture->file = fopen(path, "wb");
+        if (capture->file == NULL) {
+            fprintf(stderr, "Unable to open %s for the capture\n", path);
+            capture_destroy(capture);
+            return false;
+        }
+    }
+    if (capture->file != NULL && fwrite(header, 1, header_size, capture->file) != header_size) {
+        fprintf(stderr, "Unable to write the capture header\n");
+        capture_destroy(capture);
+        return false;
+    }
+
+    if (golden_path != NULL) {
+        capture->golden = fopen(golden_path, "rb");
+        capture->golden_frame = malloc(capture->frame_size > header_size ? capture->frame_size : header_size);
+        if (capture->golden == NULL || capture->golden_frame == NULL) {
+            fprintf(stderr, "Unable to open %s to compare against\n", golden_path);
+            capture_destroy(capture);
+            return false;
+        }
+        if (fread(capture->golden_frame, 1, header_size, capture->golden) != header_size ||
+            memcmp(capture->golden_frame, header, header_size) != 0) {
+            fprintf(stderr, "%s is not a capture of the same size, frame rate and format\n", golden_path);
+            capture_destroy(capture);
+            return false;
+        }
+    }
+
+    if (async) {
+        capture->free_slots = SDL_CreateSemaphore(CAPTURE_SLOTS);
+        capture->ready_slots = SDL_CreateSemaphore(0);
+        if (capture->free_slots == NULL || capture->ready_slots == NULL) {
+            fprintf(stderr, "Unable to create the capture semaphores! SDL Error: %s\n", SDL_GetError());
+            capture_destroy(capture);
+            return false;
+        }
+        capture->writer = SDL_CreateThread(writer_thread, "capture writer", capture);
+        if (capture->writer == NULL) {
+            fprintf(stderr, "Unable to start the capture writer! SDL Error: %s\n", SDL_GetError());
+            capture_destroy(capture);
+            return false;
+        }
+    }
+    return true;
+}
+
+bool capture_frame(FrameCapture *capture) {
+    if (atomic_load(&capture->hasFailed)) {
+        return false;
+    }
+    const long long index = capture->frame_count++;
+
+    if (!capture->isAsync) {
+        const Uint64 start = SDL_GetPerformanceCounter();
+        const uint8_t *frame = pack_frame(capture, capture->slots[0]);
+        capture->pack_counts += SDL_GetPerformanceCounter() - start;
+        consume_frame(capture, frame, index);
+        return !atomic_load(&capture->hasFailed);
+    }
+
+    // Only blocks when the writer is a whole frame behind
+    const Uint64 start = SDL_GetPerformanceCounter();
+    SDL_SemWait(capture->free_slots);
+    const Uint64 got_slot = SDL_GetPerformanceCounter();
+    capture->wait_counts += got_slot - start;
+
+    int slot = capture->next_slot;
+    capture->next_slot = (slot + 1) % CAPTURE_SLOTS;
+    pack_frame(capture, capture->slots[slot]);
+    capture->slot_frames[slot] = index;
+    capture->pack_counts += SDL_GetPerformanceCounter() - got_slot;
+    SDL_SemPost(capture->ready_slots);
+    return true;
+}
+
+bool capture_finish(FrameCapture *capture) {
+    if (capture->writer != NULL) {
+        SDL_SemWait(capture->free_slots);
+        capture->slot_frames[capture->next_slot] = -1;
+        SDL_SemPost(capture->ready_slots);
+        SDL_WaitThread(capture->writer, NULL);
+        capture->writer = NULL;
+    }
+
+    bool ok = !atomic_load(&capture->hasFailed);
+    if (capture->file != NULL) {
+        if ((capture->file == stdout ? fflush(capture->file) : fclose(capture->file)) != 0) {
+            fprintf(stderr, "Unable to finish writing the capture\n");
+            ok = false;
+        }
+        capture->file = NULL;
+    }
+    if (capture->golden != NULL) {
+        // A longer golden capture differs from the first frame it has that we don't
+        if (fgetc(capture->golden) != EOF && capture->mismatched_frames++ == 0) {
+            capture->first_mismatch = capture->frame_count;
+        }
+        fclose(capture->golden);
+        capture->golden = NULL;
+        ok = ok && capture->mismatched_frames == 0;
+    }
+    return ok;
+}
+
+void capture_destroy(FrameCapture *capture) {
+    if (capture->writer != NULL || capture->file != NULL || capture->golden != NULL) {
+        capture_finish(capture);
+    }
+    for (int i = 0; i < CAPTURE_SLOTS; i++) {
+        free(capture->slots[i]);
+    }
+    free(capture->golden_frame);
+    if (capture->free_slots != NULL) {
+        SDL_DestroySemaphore(capture->free_slots);
+    }
+    if (capture->ready_slots != NULL) {
+        SDL_DestroySemaphore(capture->ready_slots);
+    }
+    SDL_FreeSurface(capture->surface);
+    *capture = (FrameCapture){0};
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+// Offline frame capture: render() draws through a software renderer straight
+// into one surface that lives as long as the capture, and every frame is
+// packed into a buffer allocated up front and written out as Y4M video or raw
+// RGBA. With async writes, a thread of its own writes one frame while the
+// next is rendered into the other buffer.
+//
+// Against an earlier capture, each frame is compared byte for byte instead of
+// (or as well as) being written, so render() can be checked after changes.
+
+#define CAPTURE_DEFAULT_FRAMES 600
+// Frames packed and waiting for the writer, at most
+#define CAPTURE_SLOTS 2
+
+typedef enum {
+    // 4:2:0 BT.601, studio range, which ffmpeg and mpv read straight from a pipe
+    CAPTURE_Y4M,
+    // Width * height * 4 bytes per frame, R G B A, no headers at all
+    CAPTURE_RGBA,
+} CaptureFormat;
+
+typedef struct {
+    SDL_Surface *surface;
+    CaptureFormat format;
+    size_t frame_size;
+
+    // NULL when only comparing; stdout for "-"
+    FILE *file;
+    FILE *golden;
+    uint8_t *golden_frame;
+
+    uint8_t *slots[CAPTURE_SLOTS];
+    long long slot_frames[CAPTURE_SLOTS];
+    int next_slot;
+    long long frame_count;
+
+    bool isAsync;
+    SDL_Thread *writer;
+    SDL_sem *free_slots;
+    SDL_sem *ready_slots;
+    atomic_bool hasFailed;
+
+    // Written by whichever thread writes, read once it has finished
+    long long mismatched_frames;
+    long long first_mismatch;
+    Uint64 pack_counts;
+    Uint64 write_counts;
+    Uint64 wait_counts;
+} FrameCapture;
+
+bool parse_capture_format(const char *name, CaptureFormat *format);
+
+// path may be "-" for stdout, and either path may be NULL
+bool capture_open(FrameCapture *capture, const char *path, const char *golden_path, CaptureFormat format,
+                  int frame_rate, bool async);
+// Call once render() has drawn the frame into capture->surface
+bool capture_frame(FrameCapture *capture);
+// Waits for the writer and closes the files; false if a write failed or any frame differed
+bool capture_finish(FrameCapture *capture);
+// After the renderer drawing into the surface is gone
+void capture_destroy(FrameCapture *capture);
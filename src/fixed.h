@@ -0,0 +1,85 @@
+#pragma once
+
+#include <stdint.h>
+
+// Q16.16 fixed point: 16 integer bits including the sign, 16 fraction bits.
+// Only integer adds, multiplies, divides and shifts, so results are the same
+// on every compiler, optimization level and CPU. Right shifts of negative
+// values are assumed arithmetic, as on every compiler this builds with.
+
+typedef int32_t fixed;
+
+#define FIXED_SHIFT 16
+#define FIXED_ONE (1 << FIXED_SHIFT)
+#define FIXED_HALF (FIXED_ONE / 2)
+// Stands in for INFINITY: "never", or too far away to matter
+#define FIXED_MAX INT32_MAX
+
+#define FIXED_INT(n) ((fixed)(n) * FIXED_ONE)
+// 1 / pi with 32 fraction bits, for scaling long times without drift
+#define INV_PI_Q32 1367130551
+
+static inline fixed fixed_mul(fixed a, fixed b) {
+    return (fixed)(((int64_t)a * b) >> FIXED_SHIFT);
+}
+
+// Saturates to +-FIXED_MAX instead of overflowing; b must not be 0
+static inline fixed fixed_div(fixed a, fixed b) {
+    int64_t q = (int64_t)a * FIXED_ONE / b;
+    if (q > FIXED_MAX) {
+        return FIXED_MAX;
+    }
+    if (q < -FIXED_MAX) {
+        return -FIXED_MAX;
+    }
+    return (fixed)q;
+}
+
+// For converting at the edges only (options, drawing); never inside the physics
+static inline fixed fixed_from_float(float v) {
+    return (fixed)(v * FIXED_ONE + (v < 0 ? -0.5f : 0.5f));
+}
+
+static inline float fixed_to_float(fixed v) {
+    return (float)v / FIXED_ONE;
+}
+
+// Bit-by-bit integer square root, rounded down
+static inline uint32_t isqrt64(uint64_t v) {
+    uint64_t root = 0;
+    uint64_t bit = 1ull << 62;
+
+    while (bit > v) {
+        bit >>= 2;
+    }
+    while (bit != 0) {
+        if (v >= root + bit) {
+            v -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return (uint32_t)root;
+}
+
+static inline fixed fixed_sqrt(fixed v) {
+    return v > 0 ? (fixed)isqrt64((uint64_t)v << FIXED_SHIFT) : 0;
+}
+
+// sin of a whole number of turns plus a fraction, where 1.0 is 2 pi. An odd
+// seventh-order polynomial per half wave, exact at 0 and the peaks, within 2e-5
+static inline fixed fixed_sin_turns(fixed turns) {
+    // Quarter waves: z runs 0..1 up the first, 1..-1 down the middle two, -1..0 up the last
+    fixed q = (turns & (FIXED_ONE - 1)) * 4;
+    fixed z = q < FIXED_ONE ? q : q < 3 * FIXED_ONE ? 2 * FIXED_ONE - q : q - 4 * FIXED_ONE;
+
+    // a z - b z^3 + c z^5 - d z^7, fitted to sin(pi/2 z) with a - b + c - d exactly 1
+    const fixed a = 102943;
+    const fixed b = 42334;
+    const fixed c = 5216;
+    const fixed d = 289;
+    fixed z2 = fixed_mul(z, z);
+    return fixed_mul(z, a - fixed_mul(z2, b - fixed_mul(z2, c - fixed_mul(z2, d))));
+}
@@ -1,338 +1,805 @@
 #include "game.h"
 
-#include <math.h>
 #include <stdio.h>
-#include <time.h>
+#include <string.h>
 
 GameState *gState = NULL;
 
-bool init() {
+// When each step of startup finished, for --startup-trace
+#define STARTUP_MAX_MARKS 16
+
+typedef struct {
+    Uint64 start;
+    const char *names[STARTUP_MAX_MARKS];
+    Uint64 times[STARTUP_MAX_MARKS];
+    int count;
+} StartupTrace;
+
+static StartupTrace startup;
+
+static void mark_startup_at(const char *name, Uint64 time) {
+    if (startup.count < STARTUP_MAX_MARKS) {
+        startup.names[startup.count] = name;
+        startup.times[startup.count] = time;
+        startup.count++;
+    }
+}
+
+static void mark_startup(const char *name) {
+    mark_startup_at(name, SDL_GetPerformanceCounter());
+}
+
+// The window and the renderer, or the capture and a software renderer drawing into it
+static SDL_Renderer *create_renderer(const GameOptions *options, SDL_Window **window, FrameCapture **capture) {
+    if (options->capture_path != NULL || options->compare_path != NULL) {
+        // Nothing is shown, so don't ask for a display; SDL_VIDEODRIVER still wins
+        SDL_SetHint(SDL_HINT_VIDEODRIVER, "dummy");
+    }
+
     if (SDL_Init(SDL_INIT_VIDEO) < 0) {
-        ERROR_RETURN(false, "Failed to init SDL Video\n");
+        ERROR_RETURN(NULL, "Failed to init SDL Video\n");
+    }
+    mark_startup("SDL_Init");
+
+    if (options->capture_path != NULL || options->compare_path != NULL) {
+        // Frames are drawn straight into the capture's surface, with no window at all
+        *capture = malloc(sizeof(FrameCapture));
+        if (*capture == NULL || !capture_open(*capture, options->capture_path, options->compare_path,
+                                              options->capture_format, options->frame_rate, options->capture_async)) {
+            free(*capture);
+            *capture = NULL;
+            ERROR_RETURN(NULL, "Failed to start the capture!\n");
+        }
+        mark_startup("capture opened");
+        return SDL_CreateSoftwareRenderer((*capture)->surface);
     }
 
+    *window = SDL_CreateWindow("Pong", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, SCREEN_WIDTH, SCREEN_HEIGHT,
+                               SDL_WINDOW_SHOWN);
+    if (*window == NULL) {
+        ERROR_RETURN(NULL, "Failed to create a window!\n");
+    }
+    mark_startup("window created");
+
+    Uint32 renderer_flags = options->software_renderer ? SDL_RENDERER_SOFTWARE : SDL_RENDERER_ACCELERATED;
+    if (options->pacing == PACING_VSYNC) {
+        renderer_flags |= SDL_RENDERER_PRESENTVSYNC;
+    }
+    return SDL_CreateRenderer(*window, -1, renderer_flags);
+}
+
+bool init(const GameOptions *options) {
+    startup = (StartupTrace){.start = options->start_counts};
+
     if (TTF_Init() == -1) {
         ERROR_RETURN(false, "Failed to init SDL_ttf\n");
     }
 
-    SDL_Window *window = SDL_CreateWindow("Pong", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, SCREEN_WIDTH, SCREEN_HEIGHT, SDL_WINDOW_SHOWN);
-    if (window == NULL) {
-        ERROR_RETURN(false, "Failed to create a window!\n");
+    // The font is decoded and every glyph rasterized while the window and renderer come up
+    AssetLoader assets;
+    start_loading_assets(&assets);
+
+    SDL_Window *window = NULL;
+    FrameCapture *capture = NULL;
+    SDL_Renderer *renderer = create_renderer(options, &window, &capture);
+    if (renderer != NULL) {
+        mark_startup("renderer created");
     }
 
-    SDL_Renderer *renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
+    GlyphAtlas atlas;
+    bool atlas_ok = finish_loading_assets(&assets, renderer, &atlas);
+    mark_startup_at("assets decoding started", assets.decode_start);
+    mark_startup_at("assets decoded", assets.decode_end);
     if (renderer == NULL) {
         ERROR_RETURN(false, "Failed to create the renderer!\n");
     }
+    if (!atlas_ok) {
+        ERROR_RETURN(false, "Failed to build the glyph atlas!\n");
+    }
+    mark_startup("glyph atlas uploaded");
 
-    TTF_Font* font = TTF_OpenFont("../res/font.ttf", 24); // 24 is the font size
-    if (font == NULL) {
-        ERROR_RETURN(false, "Failed to load the font!\n");
+    if (!init_game_state(window, renderer, options)) {
+        ERROR_RETURN(false, "Failed to start recording or networking!\n");
     }
+    gState->capture = capture;
+    gState->atlas = atlas;
+    set_scores_text();
+    mark_startup("game state ready");
 
-    srand(time(NULL));
-    init_game_state(window, renderer);
+    return true;
+}
 
-    gState->font = font;
-    set_scores_text();
+// Called once the first frame is on screen
+static void report_startup() {
+    mark_startup("first frame presented");
+
+    // The decoding thread's marks land out of order
+    for (int i = 1; i < startup.count; i++) {
+        for (int j = i; j > 0 && startup.times[j] < startup.times[j - 1]; j--) {
+            const char *name = startup.names[j];
+            Uint64 time = startup.times[j];
+            startup.names[j] = startup.names[j - 1];
+            startup.times[j] = startup.times[j - 1];
+            startup.names[j - 1] = name;
+            startup.times[j - 1] = time;
+        }
+    }
+
+    const double ms = 1000.0 / SDL_GetPerformanceFrequency();
+    for (int i = 0; i < startup.count; i++) {
+        fprintf(stderr, "startup: %8.2f ms  %s\n", (double)(startup.times[i] - startup.start) * ms, startup.names[i]);
+    }
+}
+
+static bool init_netplay(const GameOptions *options) {
+    bool joining = options->join_address != NULL;
+
+    if (!net_init()) {
+        return false;
+    }
+    if (!net_open(&gState->socket, joining ? 0 : options->host_port)) {
+        return false;
+    }
+    if (joining) {
+        if (!net_resolve(options->join_address, &gState->peer)) {
+            return false;
+        }
+        gState->hasPeer = true;
+    } else {
+        printf("Waiting for a player on port %u\n", options->host_port);
+    }
 
+    gState->netplay = malloc(sizeof(RollbackSession));
+    if (gState->netplay == NULL) {
+        return false;
+    }
+    rollback_init(gState->netplay, options->seed, joining ? 1 : 0, options->input_delay, 1.0f / options->tick_rate);
     return true;
 }
 
-void init_game_state(SDL_Window *window, SDL_Renderer *renderer) {
+bool init_game_state(SDL_Window *window, SDL_Renderer *renderer, const GameOptions *options) {
     GameState *state = malloc(sizeof(GameState));
+    if (state == NULL) {
+        ERROR_RETURN(false, "Not enough memory for the game state\n");
+    }
+    uint64_t seed = options->seed;
 
     state->window = window;
     state->renderer = renderer;
     state->isRunning = true;
-    state->hasStarted = false;
+    atomic_init(&state->isPaused, false);
+    atomic_init(&state->isSimRunning, false);
+    state->serveRequested = false;
+    state->options = *options;
+    state->sim_thread = NULL;
+    state->probe = (LatencyProbe){0};
+    state->netplay = NULL;
+    state->hasPeer = false;
+    state->swarm = NULL;
+    state->swarm_rects = NULL;
+    state->capture = NULL;
+    // Online and stress games return before recording starts, and cleanup() checks this
+    state->isRecording = false;
+    state->replay = (ReplayWriter){0};
+
+    state->sim = (Simulation){0};
+    match_init(&state->sim.match, seed);
+    // Its own stream, so the CPU's aim doesn't shift the serves
+    ai_init(&state->sim.cpu, options->cpu, false, ~seed);
+    ai_init(&state->sim.cpu_p1, options->cpu, true, ~seed + 1);
+    state->sim.prev_match = state->sim.match;
+    state->match = state->sim.match;
+    state->prev_match = state->sim.match;
+
+    GameSnapshot initial = {.match = state->sim.match, .prev_match = state->sim.match};
+    triple_buffer_init(&state->snapshots, &initial);
+    atomic_init(&state->input, encode_input((MatchInput){0}));
+
+    render_queue_init(&state->render_queue, renderer);
 
     gState = state;
 
-    reset_paddles(false);
-    reset_ball();
+    if (options->host_port != 0 || options->join_address != NULL) {
+        return init_netplay(options);
+    }
+
+    if (options->stress_balls > 0 && !init_stress(options->stress_balls)) {
+        return false;
+    }
+
+    if (options->record_path != NULL) {
+        state->isRecording = replay_writer_open(&state->replay, options->record_path, seed, 1.0f / options->tick_rate);
+        return state->isRecording;
+    }
+    return true;
 }
 
-void game_loop() {
-    uint32_t current_time, last_time = 0;
-    float delta_time;
-    float total_time = 0;
-    while (gState->isRunning) {
-        current_time = SDL_GetTicks();
-        delta_time = (current_time - last_time) / 1000.0f;
-        last_time = current_time;
-        total_time += delta_time;
+bool init_stress(int balls) {
+    gState->swarm = malloc(sizeof(Swarm));
+    gState->swarm_rects = malloc(SWARM_MAX_BALLS * sizeof(SDL_FRect));
+    if (gState->swarm == NULL || gState->swarm_rects == NULL ||
+        !swarm_init(gState->swarm, SWARM_MAX_BALLS, ~gState->options.seed)) {
+        free(gState->swarm);
+        free(gState->swarm_rects);
+        gState->swarm = NULL;
+        gState->swarm_rects = NULL;
+        ERROR_RETURN(false, "Not enough memory for %d stress balls\n", SWARM_MAX_BALLS);
+    }
+    swarm_spawn_random(gState->swarm, balls);
+    gState->stress = (StressReport){.since = SDL_GetPerformanceCounter()};
+    return true;
+}
 
-        handle_events(delta_time);
-        handle_player_input(delta_time);
-        update_game(delta_time, total_time);
-        render();
+bool parse_pacing_mode(const char *name, PacingMode *mode) {
+    if (strcmp(name, "vsync") == 0) {
+        *mode = PACING_VSYNC;
+        return true;
+    }
+    if (strcmp(name, "sleep") == 0) {
+        *mode = PACING_SLEEP;
+        return true;
     }
+    if (strcmp(name, "uncapped") == 0) {
+        *mode = PACING_UNCAPPED;
+        return true;
+    }
+    return false;
 }
 
-void reset_paddles(bool keep_score) {
-    Paddle p1 = {
-        .pos = {
-            .x = PADDLE_WIDTH + 16,
-            .y = (SCREEN_HEIGHT / 2.0) - (PADDLE_HEIGHT / 2.0)
-        },
-        .width = PADDLE_WIDTH,
-        .height = PADDLE_HEIGHT,
-        .speed = PADDLE_SPEED,
-    };
+// Copies the newest snapshot into what render() draws
+static const GameSnapshot *take_snapshot() {
+    const GameSnapshot *snapshot = triple_buffer_read(&gState->snapshots);
+    bool scored = snapshot->match.p1.score != gState->match.p1.score || snapshot->match.p2.score != gState->match.p2.score;
 
-    Paddle p2 = {
-        .pos = {
-            .x = SCREEN_WIDTH - PADDLE_WIDTH - 16,
-            .y = (SCREEN_HEIGHT / 2.0) - (PADDLE_HEIGHT / 2.0)
-        },
-        .width = PADDLE_WIDTH,
-        .height = PADDLE_HEIGHT,
-        .speed = PADDLE_SPEED
-    };
+    gState->match = snapshot->match;
+    gState->prev_match = snapshot->prev_match;
+    if (scored) {
+        set_scores_text();
+    }
+    return snapshot;
+}
 
-    if (keep_score) {
-        p1.score = gState->p1.score;
-        p2.score = gState->p2.score;
+void game_loop() {
+    const Uint64 frequency = SDL_GetPerformanceFrequency();
+    const Uint64 tick_counts = frequency / gState->options.tick_rate;
+    const Uint64 max_frame_counts = frequency * MAX_FRAME_TIME;
+    const float dt = 1.0f / gState->options.tick_rate;
+    const bool threaded = gState->options.threaded;
+
+    Uint64 accumulator = 0;
+    Uint64 last_time = SDL_GetPerformanceCounter();
+    bool first_frame = true;
+
+    if (gState->options.latency_seconds > 0) {
+        latency_probe_start(&gState->probe, gState->options.latency_seconds);
     }
 
-    gState->p1 = p1;
-    gState->p2 = p2;
-}
+    if (threaded) {
+        atomic_store(&gState->isSimRunning, true);
+        gState->sim_thread = SDL_CreateThread(simulation_thread, "simulation", NULL);
+        if (gState->sim_thread == NULL) {
+            ERROR_EXIT("Failed to start the simulation thread! SDL Error: %s\n", SDL_GetError());
+        }
+    }
 
-void reset_ball() {
-    Ball ball = {
-        .pos = {
-            .x = SCREEN_WIDTH / 2.0,
-            .y = (SCREEN_HEIGHT / 2.0 + BALL_RADIUS / 2.0)
-        },
-        .speed = BALL_SPEED,
-        .radius = BALL_RADIUS
-    };
-    set_random_dir_ball(false, &ball);
+    while (gState->isRunning) {
+        if (gState->isPaused) {
+            // Nothing moves while paused, so sleep until something happens
+            handle_events(-1);
+            last_time = SDL_GetPerformanceCounter();
+            continue;
+        }
 
-    gState->ball = ball;
-}
+        Uint64 frame_start = SDL_GetPerformanceCounter();
+        Uint64 elapsed = frame_start - last_time;
+        last_time = frame_start;
+        accumulator += elapsed < max_frame_counts ? elapsed : max_frame_counts;
 
-void handle_events(float dt) {
-    SDL_Event e;
-    while (SDL_PollEvent(&e) != 0) {
-        if (e.type == SDL_QUIT) {
+        PROFILE_BEGIN(events);
+        handle_events(0);
+        PROFILE_END(events, PHASE_EVENTS);
+
+        if (gState->probe.isEnabled && !latency_probe_update(&gState->probe, frame_start)) {
             gState->isRunning = false;
         }
-        if (e.type == SDL_KEYDOWN) {
-            if (e.key.keysym.sym == SDLK_SPACE && !gState->hasStarted) {
-                gState->hasStarted = true;
-                set_random_dir_ball(true, NULL);
+
+        PROFILE_BEGIN(input);
+        publish_input();
+        PROFILE_END(input, PHASE_INPUT);
+
+        float alpha;
+        const GameSnapshot *snapshot;
+        if (threaded) {
+            // The simulation keeps its own clock; blend by how long ago its last tick was
+            snapshot = take_snapshot();
+            Uint64 age = SDL_GetPerformanceCounter() - snapshot->tick_time;
+            alpha = age < tick_counts ? (float)age / tick_counts : 1.0f;
+        } else {
+            // Step the simulation in fixed ticks, however long the frame took
+            PROFILE_BEGIN(update);
+            while (accumulator >= tick_counts) {
+                if (gState->netplay != NULL) {
+                    netplay_tick();
+                } else {
+                    simulation_tick(dt);
+                }
+                accumulator -= tick_counts;
             }
+            PROFILE_END(update, PHASE_UPDATE);
+
+            snapshot = take_snapshot();
+            alpha = (float)accumulator / tick_counts;
         }
+
+        render(alpha);
+        if (gState->options.startup_trace && first_frame) {
+            report_startup();
+        }
+        first_frame = false;
+        if (gState->swarm != NULL) {
+            report_stress(frame_start, SDL_GetPerformanceCounter());
+        }
+        if (gState->probe.isEnabled) {
+            latency_probe_shown(&gState->probe, snapshot->input_sequence, SDL_GetPerformanceCounter());
+        }
+
+        pace_frame(frame_start);
+        PROFILE_FRAME(frame_start, SDL_GetPerformanceCounter());
+    }
+
+    if (threaded) {
+        atomic_store(&gState->isSimRunning, false);
+        SDL_WaitThread(gState->sim_thread, NULL);
+        gState->sim_thread = NULL;
+    }
+
+    if (gState->probe.isEnabled) {
+        latency_probe_report(&gState->probe, threaded ? "threaded" : "serial");
     }
 }
 
-void update_game(float dt, float total_time) {
-    // Animate Ball
-    if (!gState->hasStarted) {
-        animate_ball(total_time);
-        return;
+bool capture_loop() {
+    const int tick_rate = gState->options.tick_rate;
+    const int frame_rate = gState->options.frame_rate;
+    const int frames = gState->options.capture_frames;
+    const float dt = 1.0f / tick_rate;
+    FrameCapture *capture = gState->capture;
+
+    const Uint64 start = SDL_GetPerformanceCounter();
+    Uint64 render_counts = 0;
+    long long ticks = 0;
+    bool ok = true;
+
+    for (long long frame = 0; frame < frames && ok; frame++) {
+        // Frame f shows the game f / frame_rate seconds in, counted exactly in
+        // ticks so no drift builds up however long the capture runs
+        long long due = frame * tick_rate / frame_rate;
+        while (ticks < due) {
+            simulation_tick(dt);
+            ticks++;
+        }
+        take_snapshot();
+
+        Uint64 render_start = SDL_GetPerformanceCounter();
+        render((float)(frame * tick_rate % frame_rate) / frame_rate);
+        render_counts += SDL_GetPerformanceCounter() - render_start;
+        if (gState->options.startup_trace && frame == 0) {
+            report_startup();
+        }
+
+        ok = capture_frame(capture);
+    }
+    ok = capture_finish(capture) && ok;
+
+    const double seconds = (double)(SDL_GetPerformanceCounter() - start) / SDL_GetPerformanceFrequency();
+    const double ms = 1000.0 / SDL_GetPerformanceFrequency() / (capture->frame_count > 0 ? capture->frame_count : 1);
+    const double video_seconds = (double)capture->frame_count / frame_rate;
+    fprintf(stderr, "capture: %lld frames (%.1f s of video) in %.2f s, %.1fx real time\n", capture->frame_count,
+            video_seconds, seconds, seconds > 0 ? video_seconds / seconds : 0);
+    fprintf(stderr, "capture: per frame render %.3f ms, pack %.3f ms, write %.3f ms, waiting on the writer %.3f ms\n",
+            render_counts * ms, capture->pack_counts * ms, capture->write_counts * ms, capture->wait_counts * ms);
+    if (gState->options.compare_path != NULL) {
+        if (capture->mismatched_frames == 0) {
+            fprintf(stderr, "compare: every frame matches %s\n", gState->options.compare_path);
+        } else {
+            fprintf(stderr, "compare: %lld frames differ from %s, the first at frame %lld\n",
+                    capture->mismatched_frames, gState->options.compare_path, capture->first_mismatch);
+        }
     }
+    return ok;
+}
 
-    // Move ball
-    Ball ball = gState->ball;
-    Paddle p1 = gState->p1;
-    Paddle p2 = gState->p2;
+// Main thread: hands the current keys, and any serve not yet taken, to the simulation
+void publish_input() {
+    MatchInput input = handle_player_input(SDL_GetKeyboardState(NULL));
+    uint32_t sequence = 0;
 
-    ball.pos.x += ball.dir.x * ball.speed * dt;
-    ball.pos.y += ball.dir.y * ball.speed * dt;
+    if (gState->probe.isEnabled) {
+        input.p1 = gState->probe.direction;
+        sequence = gState->probe.sequence;
+    }
 
-    if (ball.pos.x <= 0) {
-        gState->p2.score++;
-        set_scores_text();
-        reset_paddles(true);
-        reset_ball();
-        gState->hasStarted = false;
-        return;
+    uint64_t word = (uint64_t)sequence << 8 | encode_input(input);
+    uint64_t old = atomic_load(&gState->input);
+    while (!atomic_compare_exchange_weak(&gState->input, &old, word | (old & INPUT_SERVE_BIT))) {
     }
-    if (ball.pos.x >= SCREEN_WIDTH - BALL_RADIUS) {
-        gState->p1.score++;
-        set_scores_text();
-        reset_paddles(true);
-        reset_ball();
-        gState->hasStarted = false;
-        return;
+}
+
+// Runs one tick on whichever thread owns the simulation and publishes the result
+MatchEvent simulation_tick(float dt) {
+    Simulation *sim = &gState->sim;
+
+    // Taking the serve clears it, so a press serves exactly once
+    uint64_t word = atomic_fetch_and(&gState->input, ~(uint64_t)INPUT_SERVE_BIT);
+    MatchInput input = decode_input(word & 0xFF);
+    if (gState->options.cpu_opponent) {
+        // Either set of keys moves player 1
+        input.p1 = input.p1 != 0 ? input.p1 : input.p2;
+        input.p2 = ai_input(&sim->cpu, &sim->match, dt);
+    }
+    if (gState->capture != NULL) {
+        // Nobody is at the keyboard: the computer plays both sides and serves
+        input.p1 = ai_input(&sim->cpu_p1, &sim->match, dt);
+        input.serve = !sim->match.hasStarted;
     }
 
-    if (ball.pos.y <= 0 || ball.pos.y >= SCREEN_HEIGHT - BALL_RADIUS) {
-        ball.dir.y *= -1;
+    sim->prev_match = sim->match;
+    sim->total_time += dt;
+    if (gState->isRecording && !replay_writer_tick(&gState->replay, &sim->match, sim->total_time, input)) {
+        // Keep whatever made it to disk and play on without recording
+        replay_writer_close(&gState->replay);
+        gState->isRecording = false;
     }
 
-    // Check paddle collision
-    if (check_collision(&ball, &p1, true)) {
-        Vector2D normal = get_paddle_normal(true);
-        ball.dir = reflect_vec(ball.dir, normal);
+    MatchEvent event = step_match(&sim->match, input, dt, sim->total_time);
+    if (event != MATCH_EVENT_NONE) {
+        // Don't blend the ball back from where it scored
+        sim->prev_match = sim->match;
     }
-    if (check_collision(&ball, &p2, false)) {
-        Vector2D normal = get_paddle_normal(false);
-        ball.dir = reflect_vec(ball.dir, normal);
+    sim->tick++;
+
+    if (gState->swarm != NULL) {
+        Uint64 start = SDL_GetPerformanceCounter();
+        swarm_step(gState->swarm, &sim->match.p1, &sim->match.p2, dt);
+
+        StressReport *report = &gState->stress;
+        report->step_counts += SDL_GetPerformanceCounter() - start;
+        report->ticks++;
+        report->candidates += gState->swarm->stats.candidates;
+        report->contacts += gState->swarm->stats.contacts;
     }
 
-    gState->ball = ball;
+    GameSnapshot *snapshot = triple_buffer_back(&gState->snapshots);
+    snapshot->match = sim->match;
+    snapshot->prev_match = sim->prev_match;
+    snapshot->tick = sim->tick;
+    snapshot->tick_time = SDL_GetPerformanceCounter();
+    snapshot->input_sequence = (uint32_t)(word >> 8);
+    triple_buffer_publish(&gState->snapshots);
+
+    return event;
 }
 
-void render() {
-    SDL_Renderer *renderer = gState->renderer;
-    Paddle p1 = gState->p1;
-    Paddle p2 = gState->p2;
-    Ball ball = gState->ball;
+static void receive_packets() {
+    uint8_t packet[ROLLBACK_MAX_PACKET];
+    NetAddress from;
+    int size;
 
-    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0xFF);
-    SDL_RenderClear(renderer);
+    while ((size = net_receive(&gState->socket, &from, packet, sizeof(packet))) >= 0) {
+        if (gState->hasPeer && (from.host != gState->peer.host || from.port != gState->peer.port)) {
+            continue;
+        }
+        if (rollback_read_packet(gState->netplay, packet, size) && !gState->hasPeer) {
+            gState->peer = from;
+            gState->hasPeer = true;
+            printf("Player 2 joined from %u.%u.%u.%u:%u\n", from.host >> 24, from.host >> 16 & 0xFF,
+                   from.host >> 8 & 0xFF, from.host & 0xFF, from.port);
+        }
+    }
+}
 
-    SDL_SetRenderDrawColor(renderer, 0xFF, 0xFF, 0xFF, 0xFF);
+// Online counterpart of simulation_tick: local keys drive our paddle, the
+// rollback session predicts and corrects the other one
+void netplay_tick() {
+    RollbackSession *session = gState->netplay;
+    receive_packets();
 
-    SDL_Rect p1_rect = {p1.pos.x, p1.pos.y, p1.width, p1.height};
-    SDL_RenderFillRect(renderer, &p1_rect);
+    if (!gState->hasPeer) {
+        return;
+    }
 
-    SDL_Rect p2_rect = {p2.pos.x, p2.pos.y, p2.width, p2.height};
-    SDL_RenderFillRect(renderer, &p2_rect);
+    if (rollback_can_advance(session)) {
+        uint64_t word = atomic_fetch_and(&gState->input, ~(uint64_t)INPUT_SERVE_BIT);
+        MatchInput keys = decode_input(word & 0xFF);
+
+        // Either set of keys moves your own paddle
+        int8_t direction = keys.p1 != 0 ? keys.p1 : keys.p2;
+        MatchInput input = {
+            .p1 = session->local == 0 ? direction : 0,
+            .p2 = session->local == 1 ? direction : 0,
+            .serve = keys.serve,
+        };
+        rollback_advance(session, input);
+
+        GameSnapshot *snapshot = triple_buffer_back(&gState->snapshots);
+        snapshot->match = session->match;
+        snapshot->prev_match = *rollback_previous_match(session);
+        if (snapshot->prev_match.p1.score != session->match.p1.score ||
+            snapshot->prev_match.p2.score != session->match.p2.score) {
+            snapshot->prev_match = session->match;
+        }
+        snapshot->tick = session->frame;
+        snapshot->tick_time = SDL_GetPerformanceCounter();
+        snapshot->input_sequence = 0;
+        triple_buffer_publish(&gState->snapshots);
+    } else {
+        session->stats.stalls++;
+    }
 
-    SDL_Rect ball_rect = {ball.pos.x, ball.pos.y, ball.radius, ball.radius};
-    SDL_RenderFillRect(renderer, &ball_rect);
+    // Every tick, stalled or not, so lost packets are made up for quickly
+    uint8_t packet[ROLLBACK_MAX_PACKET];
+    size_t size = rollback_write_packet(session, packet);
+    net_send(&gState->socket, &gState->peer, packet, (int)size);
+}
 
-    SDL_SetRenderDrawColor(renderer, 0xFF, 0xFF, 0xFF, 0xFF);
-    SDL_Rect messageRect = {(SCREEN_WIDTH) / 2.0 - 24, 16, gState->font_tex_w, gState->font_tex_h};
-    SDL_RenderCopy(renderer, gState->font_tex, NULL, &messageRect);
+int simulation_thread(void *data) {
+    (void)data;
+    const Uint64 frequency = SDL_GetPerformanceFrequency();
+    const Uint64 tick_counts = frequency / gState->options.tick_rate;
+    const Uint64 max_frame_counts = frequency * MAX_FRAME_TIME;
+    const float dt = 1.0f / gState->options.tick_rate;
 
-    SDL_RenderPresent(renderer);
-}
+    Uint64 next_tick = SDL_GetPerformanceCounter();
 
-void handle_player_input(float dt) {
-    Paddle p1 = gState->p1;
-    Paddle p2 = gState->p2;
+    while (atomic_load(&gState->isSimRunning)) {
+        if (gState->isPaused) {
+            SDL_Delay(1);
+            next_tick = SDL_GetPerformanceCounter();
+            continue;
+        }
 
-    const Uint8 *currentKeyStates = SDL_GetKeyboardState(NULL);
+        wait_until(next_tick);
+        simulation_tick(dt);
+        next_tick += tick_counts;
 
-    if (currentKeyStates[SDL_SCANCODE_W]) {
-            p1.pos.y -= p1.speed * dt;
-    }
-    if (currentKeyStates[SDL_SCANCODE_S]) {
-            p1.pos.y += p1.speed * dt;
+        // After a stall, drop the missed ticks rather than racing through them
+        Uint64 now = SDL_GetPerformanceCounter();
+        if (now > next_tick + max_frame_counts) {
+            next_tick = now;
+        }
     }
-    if (currentKeyStates[SDL_SCANCODE_UP]) {
-            p2.pos.y -= p2.speed * dt;
+    return 0;
+}
+
+void pace_frame(Uint64 frame_start) {
+    const Uint64 frequency = SDL_GetPerformanceFrequency();
+    const Uint64 deadline = frame_start + frequency / gState->options.frame_rate;
+    bool idle = !gState->match.hasStarted;
+
+    if (!idle && gState->options.pacing != PACING_SLEEP) {
+        // vsync already waited inside SDL_RenderPresent
+        return;
     }
-    if (currentKeyStates[SDL_SCANCODE_DOWN]) {
-            p2.pos.y += p2.speed * dt;
+
+    Uint64 now = SDL_GetPerformanceCounter();
+    if (now >= deadline) {
+        return;
     }
 
-    if (p1.pos.y <= 0) {
-        p1.pos.y += p1.speed * dt;
+    if (idle) {
+        // Waiting for the serve: wake up on input or for the next animation frame
+        handle_events((int)((deadline - now) * 1000 / frequency));
+        return;
     }
-    if (p1.pos.y >= SCREEN_HEIGHT - p1.height) {
-        p1.pos.y -= p1.speed * dt;
+
+    wait_until(deadline);
+}
+
+void wait_until(Uint64 deadline) {
+    const Uint64 frequency = SDL_GetPerformanceFrequency();
+    Uint64 now = SDL_GetPerformanceCounter();
+    if (now >= deadline) {
+        return;
     }
-    if (p2.pos.y <= 0) {
-        p2.pos.y += p2.speed * dt;
+
+    // Sleep most of the way, then spin the last millisecond to hit the deadline
+    int remaining_ms = (int)((deadline - now) * 1000 / frequency);
+    if (remaining_ms > 1) {
+        SDL_Delay(remaining_ms - 1);
     }
-    if (p2.pos.y >= SCREEN_HEIGHT - p2.height) {
-        p2.pos.y -= p2.speed * dt;
+    while (SDL_GetPerformanceCounter() < deadline) {
     }
-
-    gState->p1 = p1;
-    gState->p2 = p2;
 }
 
-void cleanup() {
-    SDL_DestroyWindow(gState->window);
-    gState->window = NULL;
-
-    SDL_DestroyRenderer(gState->renderer);
-    gState->renderer = NULL;
+void handle_events(int timeout_ms) {
+    SDL_Event e;
 
-    SDL_DestroyTexture(gState->font_tex);
-    gState->font_tex = NULL;
+    // timeout_ms < 0 blocks until an event arrives, 0 only polls
+    if (timeout_ms != 0) {
+        int got_event = timeout_ms < 0 ? SDL_WaitEvent(&e) : SDL_WaitEventTimeout(&e, timeout_ms);
+        if (got_event) {
+            handle_event(&e);
+        }
+    }
 
-    free(gState);
-    gState = NULL;
+    while (SDL_PollEvent(&e) != 0) {
+        handle_event(&e);
+    }
+}
 
-    TTF_Quit();
-    SDL_Quit();
+void handle_event(const SDL_Event *e) {
+    if (e->type == SDL_QUIT) {
+        gState->isRunning = false;
+    }
+    if (e->type == SDL_KEYDOWN) {
+        if (e->key.keysym.sym == SDLK_SPACE && !gState->match.hasStarted) {
+            gState->serveRequested = true;
+        }
+        // Pausing one side of an online match would only stall the other
+        if (e->key.keysym.sym == SDLK_p && gState->match.hasStarted && gState->netplay == NULL) {
+            gState->isPaused = !gState->isPaused;
+        }
+        if (e->key.keysym.sym == SDLK_F3) {
+            PROFILE_TOGGLE_OVERLAY();
+        }
+        if (gState->swarm != NULL && (e->key.keysym.sym == SDLK_EQUALS || e->key.keysym.sym == SDLK_KP_PLUS)) {
+            swarm_spawn_random(gState->swarm, STRESS_SPAWN_STEP);
+        }
+        if (gState->swarm != NULL && (e->key.keysym.sym == SDLK_MINUS || e->key.keysym.sym == SDLK_KP_MINUS)) {
+            swarm_despawn_some(gState->swarm, STRESS_SPAWN_STEP);
+        }
+    }
+    if (e->type == SDL_WINDOWEVENT && e->window.event == SDL_WINDOWEVENT_EXPOSED) {
+        render_queue_invalidate(&gState->render_queue);
+    }
 }
 
-void animate_ball(float total_time) {
-    gState->ball.pos.y = (sin(total_time * 2) + 1) / 2 * (SCREEN_HEIGHT - 5 * BALL_RADIUS) + BALL_RADIUS;
+static Vector2D lerp_vec(Vector2D from, Vector2D to, float alpha) {
+    return (Vector2D){
+        .x = from.x + (to.x - from.x) * alpha,
+        .y = from.y + (to.y - from.y) * alpha
+    };
 }
 
-void set_random_dir_ball(bool is_global_state, Ball *ball) {
-    float x, y, length;
+void render(float alpha) {
+    PROFILE_BEGIN(render);
+    SDL_Renderer *renderer = gState->renderer;
+    const Match *prev = &gState->prev_match;
+    Paddle p1 = gState->match.p1;
+    Paddle p2 = gState->match.p2;
+    Ball ball = gState->match.ball;
+
+    // Draw in between the last two ticks so motion is smooth at any tick rate
+    p1.pos = lerp_vec(prev->p1.pos, p1.pos, alpha);
+    p2.pos = lerp_vec(prev->p2.pos, p2.pos, alpha);
+    ball.pos = lerp_vec(prev->ball.pos, ball.pos, alpha);
+
+    const SDL_Color white = {0xFF, 0xFF, 0xFF, 0xFF};
+    RenderQueue *queue = &gState->render_queue;
+    render_queue_begin(queue, (SDL_Color){0, 0, 0, 0xFF});
+
+    for (int y = CENTER_LINE_DASH / 2; y < SCREEN_HEIGHT; y += 2 * CENTER_LINE_DASH) {
+        SDL_FRect dash = {(SCREEN_WIDTH - CENTER_LINE_WIDTH) / 2, y, CENTER_LINE_WIDTH, CENTER_LINE_DASH};
+        push_rect(queue, LAYER_FIELD, dash, white, SDL_BLENDMODE_NONE);
+    }
 
-    x = ((float)rand() / RAND_MAX) - 0.5;
-    y = ((float)rand() / RAND_MAX) - 0.5;
+    // Whole pixels, as SDL_RenderFillRect drew them, so nothing blurs or shimmers
+    SDL_FRect p1_rect = {(int)p1.pos.x, (int)p1.pos.y, p1.width, p1.height};
+    push_rect(queue, LAYER_FIELD, p1_rect, white, SDL_BLENDMODE_NONE);
 
-    //Normalize the vector
-    length = sqrt(x*x + y*y);
-    x /= length;
-    y /= length;
+    SDL_FRect p2_rect = {(int)p2.pos.x, (int)p2.pos.y, p2.width, p2.height};
+    push_rect(queue, LAYER_FIELD, p2_rect, white, SDL_BLENDMODE_NONE);
 
-   if (!is_global_state) {
-       ball->dir.x = x;
-       ball->dir.y = y;
-   } else {
-       gState->ball.dir.x = x;
-       gState->ball.dir.y = y;
-   }
-}
+    SDL_FRect ball_rect = {(int)ball.pos.x, (int)ball.pos.y, ball.radius, ball.radius};
+    push_rect(queue, LAYER_FIELD, ball_rect, white, SDL_BLENDMODE_NONE);
 
-bool check_collision(Ball *ball, Paddle *p, bool is_left_side) {
-    if (is_left_side) {
-        if (ball->pos.x >= p->pos.x && ball->pos.x <= p->pos.x + p->width &&
-            ball->pos.y >= p->pos.y && ball->pos.y <= p->pos.y + p->height) {
-            return true;
-        }
-    } else {
-        if (ball->pos.x + ball->radius <= p->pos.x + p->width && ball->pos.x + ball->radius >= p->pos.x &&
-            ball->pos.y >= p->pos.y && ball->pos.y <= p->pos.y + p->height) {
-            return true;
+    // Stress balls are drawn where the last tick left them, all in one call
+    const Swarm *swarm = gState->swarm;
+    if (swarm != NULL) {
+        int count = 0;
+        for (int i = 0; i < swarm->used; i++) {
+            if (swarm->balls[i].isAlive) {
+                Vector2D pos = swarm->balls[i].pos;
+                gState->swarm_rects[count++] = (SDL_FRect){(int)pos.x, (int)pos.y, SWARM_BALL_SIZE, SWARM_BALL_SIZE};
+            }
         }
+        push_rect_array(queue, LAYER_FIELD, gState->swarm_rects, count, white);
     }
 
-    return false;
+    int text_w = measure_text(&gState->atlas, gState->score_text);
+    queue_text(queue, LAYER_HUD, &gState->atlas, gState->score_text, (SCREEN_WIDTH - text_w) / 2, 16, white);
+
+    PROFILE_DRAW_OVERLAY(queue, &gState->atlas);
+    render_queue_flush(queue, renderer);
+    PROFILE_END(render, PHASE_RENDER);
+
+    PROFILE_BEGIN(present);
+    SDL_RenderPresent(renderer);
+    PROFILE_END(present, PHASE_PRESENT);
 }
 
-Vector2D get_paddle_normal(bool is_left_side) {
-    if (is_left_side) {
-        return (Vector2D){.x = 1.0f, .y = 0};
+void report_stress(Uint64 frame_start, Uint64 frame_end) {
+    StressReport *report = &gState->stress;
+    Uint64 frame = frame_end - frame_start;
+    report->frames++;
+    report->frame_counts += frame;
+    if (frame > report->max_frame_counts) {
+        report->max_frame_counts = frame;
+    }
+
+    const double ms = 1000.0 / SDL_GetPerformanceFrequency();
+    if ((frame_end - report->since) * ms < 1000) {
+        return;
     }
-    return (Vector2D){.x = -1.0f, .y = 0};
+
+    int ticks = report->ticks > 0 ? report->ticks : 1;
+    printf("stress: %5d balls, frame %6.2f ms (max %6.2f), step %6.2f ms, %8lld candidate pairs, %6lld contacts "
+           "per tick\n",
+           gState->swarm->count, report->frame_counts * ms / report->frames, report->max_frame_counts * ms,
+           report->step_counts * ms / ticks, report->candidates / ticks, report->contacts / ticks);
+    *report = (StressReport){.since = frame_end};
 }
 
-Vector2D reflect_vec(Vector2D vec, Vector2D normal) {
-    float dot = vec.x * normal.x + vec.y * normal.y;
-    Vector2D r = {
-        vec.x - 2 * dot * normal.x,
-        vec.y - 2 * dot * normal.y
+MatchInput handle_player_input(const Uint8 *key_states) {
+    MatchInput input = {
+        .p1 = key_states[SDL_SCANCODE_S] - key_states[SDL_SCANCODE_W],
+        .p2 = key_states[SDL_SCANCODE_DOWN] - key_states[SDL_SCANCODE_UP],
+        .serve = gState->serveRequested,
     };
-    return r;
+    gState->serveRequested = false;
+
+    return input;
 }
 
-void set_scores_text() {
-    SDL_Color textColor = {0xFF, 0xFF, 0xFF, 0xFF};
-    char buffer[20];
-    snprintf(buffer, sizeof(buffer), "%i  :  %i", gState->p1.score, gState->p2.score);
-    SDL_Surface* surfaceMessage = TTF_RenderText_Solid(gState->font, buffer, textColor);
-    if (surfaceMessage == NULL) {
-        ERROR_EXIT("Unable to render text surface! SDL_ttf Error: %s\n", TTF_GetError());
+void cleanup() {
+#ifdef PONG_PROFILER
+    if (gState->options.profile_path != NULL) {
+        profiler_dump(gState->options.profile_path);
+    }
+#endif
+
+    if (gState->isRecording) {
+        replay_writer_close(&gState->replay);
+    }
+
+    if (gState->netplay != NULL) {
+        const RollbackStats *stats = &gState->netplay->stats;
+        printf("netplay: %lld frames, %lld rollbacks, %lld frames resimulated (max %d), %lld stalls\n", stats->frames,
+               stats->rollbacks, stats->resimulated, stats->max_rollback, stats->stalls);
+        net_close(&gState->socket);
+        net_shutdown();
+        free(gState->netplay);
     }
 
-    // Convert surface to texture
-    SDL_Texture* message = SDL_CreateTextureFromSurface(gState->renderer, surfaceMessage);
-    if (message == NULL) {
-        ERROR_EXIT("Unable to create texture from rendered text! SDL Error: %s\n", SDL_GetError());
+    if (gState->swarm != NULL) {
+        swarm_destroy(gState->swarm);
+        free(gState->swarm);
+        free(gState->swarm_rects);
     }
 
-    gState->font_tex_w = surfaceMessage->w;
-    gState->font_tex_h = surfaceMessage->h;
+    destroy_glyph_atlas(&gState->atlas);
 
-    SDL_FreeSurface(surfaceMessage);
+    SDL_DestroyRenderer(gState->renderer);
+    gState->renderer = NULL;
 
-    gState->font_tex = message;
+    if (gState->capture != NULL) {
+        capture_destroy(gState->capture);
+        free(gState->capture);
+    }
+
+    if (gState->window != NULL) {
+        SDL_DestroyWindow(gState->window);
+        gState->window = NULL;
+    }
+
+    free(gState);
+    gState = NULL;
+
+    TTF_Quit();
+    SDL_Quit();
+}
+
+void set_scores_text() {
+    snprintf(gState->score_text, sizeof(gState->score_text), "%i  :  %i", gState->match.p1.score,
+             gState->match.p2.score);
 }
@@ -3,80 +3,177 @@
 #include <SDL2/SDL_ttf.h>
 #include <SDL2/SDL.h>
 
+#include <stdatomic.h>
 #include <stdio.h>
 
-typedef struct {
-    float x;
-    float y;
-} Vector2D;
+#include "ai.h"
+#include "assets.h"
+#include "capture.h"
+#include "glyph_atlas.h"
+#include "latency_probe.h"
+#include "net.h"
+#include "profiler.h"
+#include "render_queue.h"
+#include "replay.h"
+#include "rollback.h"
+#include "sim.h"
+#include "swarm.h"
+#include "triple_buffer.h"
+
+typedef enum {
+    PACING_VSYNC,
+    PACING_SLEEP,
+    PACING_UNCAPPED,
+} PacingMode;
 
 typedef struct {
-    Vector2D pos;
-
-    float width;
-    float height;
-    float speed;
-    int score;
-} Paddle;
-
+    int tick_rate;
+    int frame_rate;
+    PacingMode pacing;
+    const char *record_path;
+    // Where the profiler writes its trace on exit (profiler builds only)
+    const char *profile_path;
+    // Force SDL's software renderer, e.g. for benchmarks on machines without a GPU
+    bool software_renderer;
+    // Simulate on a thread of its own instead of between frames
+    bool threaded;
+    // Run the latency probe for this long, then quit; 0 to play normally
+    float latency_seconds;
+    // Seeds the match; online, both players must use the same one
+    uint64_t seed;
+    // Online play: host on host_port as player 1, or join "host:port" as player 2
+    uint16_t host_port;
+    const char *join_address;
+    int input_delay;
+    // Player 2 is the computer, at this difficulty
+    bool cpu_opponent;
+    AiDifficulty cpu;
+    // Stress mode: start with this many small balls on the field as well
+    int stress_balls;
+    // Capture: render this many frames offline into capture_path ("-" for stdout) and/or compare them with
+    // compare_path, as fast as they render, with the computer playing both sides
+    const char *capture_path;
+    const char *compare_path;
+    CaptureFormat capture_format;
+    int capture_frames;
+    // Write captured frames on a thread of their own
+    bool capture_async;
+    // Print how long after start_counts (taken first thing in main) each step of
+    // startup finished, up to the first frame
+    bool startup_trace;
+    Uint64 start_counts;
+} GameOptions;
+
+// Owned by whichever thread runs the simulation
 typedef struct {
-    Vector2D pos;
-    Vector2D dir;
-    float speed;
-    float radius;
-} Ball;
+    Match match;
+    Match prev_match;
+    float total_time;
+    uint64_t tick;
+    // Player 2 when options.cpu_opponent is set
+    AiPlayer cpu;
+    // Player 1 as well in a capture, where nobody is at the keyboard
+    AiPlayer cpu_p1;
+} Simulation;
+
+// Stress mode figures, summed up and printed once a second
+typedef struct {
+    Uint64 since;
+    int frames;
+    int ticks;
+    Uint64 frame_counts;
+    Uint64 max_frame_counts;
+    Uint64 step_counts;
+    long long candidates;
+    long long contacts;
+} StressReport;
 
 typedef struct {
     SDL_Window *window;
     SDL_Renderer *renderer;
-    TTF_Font *font;
-    SDL_Texture *font_tex;
-    float font_tex_w;
-    float font_tex_h;
+    GlyphAtlas atlas;
+    RenderQueue render_queue;
+    char score_text[32];
+
+    GameOptions options;
+
+    // What the main thread draws: the latest snapshot, blended with the tick before it
+    Match match;
+    Match prev_match;
 
-    Paddle p1;
-    Paddle p2;
+    Simulation sim;
+    TripleBuffer snapshots;
+    SDL_Thread *sim_thread;
+    // Latest input from the main thread: probe sequence << 8 | encode_input()
+    atomic_uint_fast64_t input;
 
-    Ball ball;
+    ReplayWriter replay;
+    LatencyProbe probe;
+
+    // Online play; NULL when both players share this keyboard
+    RollbackSession *netplay;
+    NetSocket socket;
+    NetAddress peer;
+
+    // Stress mode; NULL in a normal game. Only ever serial, so the main thread owns it
+    Swarm *swarm;
+    SDL_FRect *swarm_rects;
+    StressReport stress;
+
+    // Capturing frames instead of showing them; NULL otherwise, and then there is no window
+    FrameCapture *capture;
 
     bool isRunning;
-    bool hasStarted;
-    bool isPaused;
+    atomic_bool isPaused;
+    atomic_bool isSimRunning;
+    bool isRecording;
+    // Space was pressed; the serve goes into the next tick's input
+    bool serveRequested;
+    // The host learns its opponent's address from the first packet
+    bool hasPeer;
 } GameState;
 
+extern GameState *gState;
+
 #define ERROR_EXIT(...) fprintf(stderr, __VA_ARGS__); return
 #define ERROR_RETURN(R, ...) fprintf(stderr, __VA_ARGS__); return R
 
-#define SCREEN_WIDTH  640
-#define SCREEN_HEIGHT 480
+#define DEFAULT_TICK_RATE 120
+#define DEFAULT_FRAME_RATE 60
+// Dashes down the middle of the field
+#define CENTER_LINE_WIDTH 4
+#define CENTER_LINE_DASH 16
+
+// Longest frame the accumulator will catch up on, so a stall doesn't snowball
+#define MAX_FRAME_TIME 0.25
 
-#define PADDLE_WIDTH 10
-#define PADDLE_HEIGHT 125
-#define BALL_RADIUS 15
-#define PADDLE_SPEED 300
-#define BALL_SPEED 225
+// Balls added or removed per press of + or - in stress mode
+#define STRESS_SPAWN_STEP 500
 
-bool init();
-void init_game_state(SDL_Window *window, SDL_Renderer *renderer);
+bool init(const GameOptions *options);
+bool init_game_state(SDL_Window *window, SDL_Renderer *renderer, const GameOptions *options);
+bool parse_pacing_mode(const char *name, PacingMode *mode);
+bool init_stress(int balls);
 
 void game_loop();
+// Renders options.capture_frames frames into the capture; false if writing failed or a frame differed
+bool capture_loop();
 
-void reset_paddles(bool keep_score);
-void reset_ball();
 void set_scores_text();
 
-void handle_events(float dt);
-void update_game(float dt, float total_time);
-void render();
-
-void handle_player_input(float dt);
+void handle_events(int timeout_ms);
+void handle_event(const SDL_Event *e);
+void render(float alpha);
+void pace_frame(Uint64 frame_start);
+void report_stress(Uint64 frame_start, Uint64 frame_end);
+void wait_until(Uint64 deadline);
 
-void animate_ball(float total_time);
-void set_random_dir_ball(bool is_global_state, Ball *ball);
+void publish_input();
+MatchEvent simulation_tick(float dt);
+void netplay_tick();
+int simulation_thread(void *data);
 
-bool check_collision(Ball *ball, Paddle *p, bool is_left_side);
-Vector2D get_paddle_normal( bool is_left_side);
-Vector2D reflect_vec(Vector2D vec, Vector2D normal);
-Vector2D find_vec_between_two_pos(Vector2D pos1, Vector2D po2);
+// key_states is indexed by SDL_Scancode, as returned by SDL_GetKeyboardState
+MatchInput handle_player_input(const Uint8 *key_states);
 
 void cleanup();
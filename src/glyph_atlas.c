@@ -0,0 +1,97 @@
+#include "glyph_atlas.h"
+
+#include "game.h"
+
+static const Glyph *find_glyph(const GlyphAtlas *atlas, char c) {
+    if (c < GLYPH_FIRST || c > GLYPH_LAST) {
+        c = '?';
+    }
+    return &atlas->glyphs[c - GLYPH_FIRST];
+}
+
+SDL_Surface *rasterize_glyph_atlas(GlyphAtlas *atlas, TTF_Font *font) {
+    SDL_Color white = {0xFF, 0xFF, 0xFF, 0xFF};
+    SDL_Surface *surfaces[GLYPH_COUNT] = {0};
+    SDL_Surface *sheet = NULL;
+
+    *atlas = (GlyphAtlas){.line_height = TTF_FontHeight(font)};
+
+    // Shelf-pack the glyphs into rows of GLYPH_ATLAS_WIDTH
+    int x = 0;
+    int y = 0;
+    for (int i = 0; i < GLYPH_COUNT; i++) {
+        surfaces[i] = TTF_RenderGlyph_Blended(font, GLYPH_FIRST + i, white);
+        if (surfaces[i] == NULL) {
+            fprintf(stderr, "Unable to render glyph '%c'! SDL_ttf Error: %s\n", GLYPH_FIRST + i, TTF_GetError());
+            goto done;
+        }
+
+        if (x + surfaces[i]->w > GLYPH_ATLAS_WIDTH) {
+            x = 0;
+            y += atlas->line_height;
+        }
+        atlas->glyphs[i].src = (SDL_Rect){x, y, surfaces[i]->w, surfaces[i]->h};
+        x += surfaces[i]->w;
+    }
+    atlas->width = GLYPH_ATLAS_WIDTH;
+    atlas->height = y + atlas->line_height;
+
+    sheet = SDL_CreateRGBSurfaceWithFormat(0, atlas->width, atlas->height, 32, SDL_PIXELFORMAT_RGBA32);
+    if (sheet == NULL) {
+        fprintf(stderr, "Unable to create the glyph atlas surface! SDL Error: %s\n", SDL_GetError());
+        goto done;
+    }
+    SDL_FillRect(sheet, NULL, SDL_MapRGBA(sheet->format, 0xFF, 0xFF, 0xFF, 0));
+
+    for (int i = 0; i < GLYPH_COUNT; i++) {
+        // Copy coverage into the alpha channel as-is instead of blending it
+        SDL_SetSurfaceBlendMode(surfaces[i], SDL_BLENDMODE_NONE);
+        SDL_BlitSurface(surfaces[i], NULL, sheet, &atlas->glyphs[i].src);
+    }
+
+done:
+    for (int i = 0; i < GLYPH_COUNT; i++) {
+        SDL_FreeSurface(surfaces[i]);
+    }
+    return sheet;
+}
+
+bool upload_glyph_atlas(GlyphAtlas *atlas, SDL_Renderer *renderer, SDL_Surface *sheet) {
+    atlas->texture = SDL_CreateTextureFromSurface(renderer, sheet);
+    SDL_FreeSurface(sheet);
+    if (atlas->texture == NULL) {
+        fprintf(stderr, "Unable to create the glyph atlas texture! SDL Error: %s\n", SDL_GetError());
+        return false;
+    }
+    SDL_SetTextureBlendMode(atlas->texture, SDL_BLENDMODE_BLEND);
+    return true;
+}
+
+void destroy_glyph_atlas(GlyphAtlas *atlas) {
+    SDL_DestroyTexture(atlas->texture);
+    atlas->texture = NULL;
+}
+
+int measure_text(const GlyphAtlas *atlas, const char *text) {
+    int width = 0;
+    for (const char *c = text; *c != '\0'; c++) {
+        width += find_glyph(atlas, *c)->src.w;
+    }
+    return width;
+}
+
+void queue_text(RenderQueue *queue, RenderLayer layer, const GlyphAtlas *atlas, const char *text, int x, int y,
+                SDL_Color color) {
+    const float u_scale = 1.0f / atlas->width;
+    const float v_scale = 1.0f / atlas->height;
+
+    for (const char *c = text; *c != '\0'; c++) {
+        const SDL_Rect *src = &find_glyph(atlas, *c)->src;
+        if (*c != ' ') {
+            SDL_FRect dst = {x, y, src->w, src->h};
+            SDL_FRect uv = {src->x * u_scale, src->y * v_scale, src->w * u_scale, src->h * v_scale};
+            push_textured_quad(queue, layer, atlas->texture, dst, uv, color);
+        }
+        x += src->w;
+    }
+}
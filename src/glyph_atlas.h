@@ -0,0 +1,41 @@
+#pragma once
+
+#include <SDL2/SDL_ttf.h>
+#include <SDL2/SDL.h>
+
+#include <stdbool.h>
+
+#include "render_queue.h"
+
+// Every printable ASCII character, rasterized once into a single texture.
+// Text is queued as textured quads from it, so HUD updates never touch
+// SDL_ttf or allocate, and all text shares one draw call.
+
+#define GLYPH_FIRST ' '
+#define GLYPH_LAST '~'
+#define GLYPH_COUNT (GLYPH_LAST - GLYPH_FIRST + 1)
+
+#define GLYPH_ATLAS_WIDTH 512
+
+typedef struct {
+    SDL_Rect src;
+} Glyph;
+
+typedef struct {
+    SDL_Texture *texture;
+    int width;
+    int height;
+    int line_height;
+    Glyph glyphs[GLYPH_COUNT];
+} GlyphAtlas;
+
+// Everything that doesn't need the renderer, so it may run on any thread: every
+// glyph laid out and rasterized into one sheet, or NULL on failure
+SDL_Surface *rasterize_glyph_atlas(GlyphAtlas *atlas, TTF_Font *font);
+// Makes the sheet the atlas's texture, and frees it either way
+bool upload_glyph_atlas(GlyphAtlas *atlas, SDL_Renderer *renderer, SDL_Surface *sheet);
+void destroy_glyph_atlas(GlyphAtlas *atlas);
+
+int measure_text(const GlyphAtlas *atlas, const char *text);
+void queue_text(RenderQueue *queue, RenderLayer layer, const GlyphAtlas *atlas, const char *text, int x, int y,
+                SDL_Color color);
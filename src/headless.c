@@ -0,0 +1,219 @@
+#include "headless.h"
+
+#include "timer.h"
+
+#include <stdio.h>
+#include <string.h>
+
+static float random_aim_offset(uint64_t *rng, const PlayerProfile *player) {
+    return (random_float(rng) - 0.5f) * player->aim_error * PADDLE_HEIGHT;
+}
+
+bool parse_player_kind(const char *name, PlayerKind *kind) {
+    if (strcmp(name, "ai") == 0) {
+        *kind = PLAYER_AI;
+        return true;
+    }
+    if (strcmp(name, "script") == 0) {
+        *kind = PLAYER_SCRIPT;
+        return true;
+    }
+    if (strcmp(name, "cpu") == 0) {
+        *kind = PLAYER_CPU;
+        return true;
+    }
+    return false;
+}
+
+int8_t headless_player_input(PlayerKind kind, const Match *match, bool is_left_side, float aim_offset, float match_time) {
+    const Paddle *p = is_left_side ? &match->p1 : &match->p2;
+
+    if (kind == PLAYER_SCRIPT) {
+        // Sweep up for a second, then down for a second
+        return ((int)match_time & 1) ? 1 : -1;
+    }
+
+    const Ball *ball = &match->ball;
+    bool incoming = is_left_side ? ball->dir.x < 0 : ball->dir.x > 0;
+    float target = incoming ? ball->pos.y + aim_offset : SCREEN_HEIGHT / 2.0f;
+    float center = p->pos.y + p->height / 2.0f;
+
+    if (target < center - BALL_RADIUS) {
+        return -1;
+    }
+    if (target > center + BALL_RADIUS) {
+        return 1;
+    }
+    return 0;
+}
+
+void play_match(uint64_t seed, const PlayerProfile *p1, const PlayerProfile *p2, float dt, PhysicsBackend physics,
+                MatchResult *result, ReplayWriter *replay) {
+    uint64_t rng = seed;
+    uint64_t match_seed = random_u64(&rng);
+    const bool is_fixed = physics == PHYSICS_FIXED;
+    const fixed fixed_dt = fixed_from_float(dt);
+
+    // The players always look at a float Match; on the fixed backend it is a
+    // copy of the real state, refreshed every tick
+    Match match;
+    FixedMatch fixed_match;
+    match_init(&match, match_seed);
+    if (is_fixed) {
+        fixed_match_init(&fixed_match, match_seed);
+        fixed_match_to_float(&fixed_match, &match);
+    }
+
+    *result = (MatchResult){0};
+
+    float match_time = 0;
+    fixed fixed_time = 0;
+    float rally_time = 0;
+    int rally = 0;
+    float aim_p1 = random_aim_offset(&rng, p1);
+    float aim_p2 = random_aim_offset(&rng, p2);
+    bool heading_left = match.ball.dir.x < 0;
+
+    // CPU players keep their own prediction and aim; the others share the stream above
+    AiPlayer cpu_p1;
+    AiPlayer cpu_p2;
+    if (p1->kind == PLAYER_CPU) {
+        AiDifficulty difficulty = {.reaction_time = p1->reaction_time, .aim_error = p1->aim_error};
+        ai_init(&cpu_p1, difficulty, true, random_u64(&rng));
+    }
+    if (p2->kind == PLAYER_CPU) {
+        AiDifficulty difficulty = {.reaction_time = p2->reaction_time, .aim_error = p2->aim_error};
+        ai_init(&cpu_p2, difficulty, false, random_u64(&rng));
+    }
+
+    if (replay != NULL) {
+        replay_writer_mark_reset(replay);
+    }
+
+    while (!is_match_over(&match)) {
+        MatchInput input = {
+            .p1 = p1->kind == PLAYER_CPU ? ai_input(&cpu_p1, &match, dt)
+                                         : headless_player_input(p1->kind, &match, true, aim_p1, match_time),
+            .p2 = p2->kind == PLAYER_CPU ? ai_input(&cpu_p2, &match, dt)
+                                         : headless_player_input(p2->kind, &match, false, aim_p2, match_time),
+            .serve = true,
+        };
+        if (replay != NULL && !replay_writer_tick(replay, &match, match_time, input)) {
+            replay = NULL;
+        }
+
+        MatchEvent event;
+        if (is_fixed) {
+            event = fixed_step_match(&fixed_match, input, fixed_dt, fixed_time);
+            fixed_time += fixed_dt;
+        } else {
+            event = step_match(&match, input, dt, match_time);
+        }
+        match_time += dt;
+        rally_time += dt;
+        result->ticks++;
+
+        // A re-served ball heads off in a new direction nobody hit it in
+        bool reserved = false;
+        if (event != MATCH_EVENT_NONE) {
+            result->points++;
+            rally_time = 0;
+            rally = 0;
+        } else if (rally_time >= HEADLESS_RALLY_TIMEOUT) {
+            if (is_fixed) {
+                fixed_reset_ball(&fixed_match);
+            } else {
+                reset_ball(&match);
+            }
+            if (replay != NULL) {
+                replay_writer_mark_reset(replay);
+            }
+            rally_time = 0;
+            rally = 0;
+            result->timeouts++;
+            reserved = true;
+        }
+        if (is_fixed) {
+            fixed_match_to_float(&fixed_match, &match);
+        }
+
+        // Pick a new aim for every shot, not just every point
+        if ((match.ball.dir.x < 0) != heading_left) {
+            heading_left = match.ball.dir.x < 0;
+            aim_p1 = random_aim_offset(&rng, p1);
+            aim_p2 = random_aim_offset(&rng, p2);
+
+            if (event == MATCH_EVENT_NONE && !reserved) {
+                rally++;
+                result->hits++;
+                if (rally > result->longest_rally) {
+                    result->longest_rally = rally;
+                }
+            }
+        }
+    }
+
+    result->p1_score = match.p1.score;
+    result->p2_score = match.p2.score;
+    result->duration = match_time;
+}
+
+int run_headless(const HeadlessOptions *options) {
+    const PlayerProfile p1 = {
+        .kind = options->p1,
+        .aim_error = options->p1 == PLAYER_CPU ? options->cpu.aim_error : DEFAULT_AIM_ERROR,
+        .reaction_time = options->cpu.reaction_time,
+    };
+    const PlayerProfile p2 = {
+        .kind = options->p2,
+        .aim_error = options->p2 == PLAYER_CPU ? options->cpu.aim_error : DEFAULT_AIM_ERROR,
+        .reaction_time = options->cpu.reaction_time,
+    };
+    uint64_t rng = options->seed;
+    long long points = 0;
+    long long ticks = 0;
+    int timeouts = 0;
+    int p1_wins = 0;
+    int p2_wins = 0;
+
+    ReplayWriter replay;
+    bool recording = options->record_path != NULL;
+    if (recording && options->physics != PHYSICS_FLOAT) {
+        fprintf(stderr, "Replays record the float simulation; rebuild without PONG_FIXED_POINT to record\n");
+        return -1;
+    }
+    if (recording && !replay_writer_open(&replay, options->record_path, options->seed, options->dt)) {
+        return -1;
+    }
+
+    double start = timer_seconds();
+
+    for (int i = 0; i < options->matches; i++) {
+        MatchResult result;
+        play_match(random_u64(&rng), &p1, &p2, options->dt, options->physics, &result, recording ? &replay : NULL);
+
+        points += result.points;
+        ticks += result.ticks;
+        timeouts += result.timeouts;
+        if (result.p1_score > result.p2_score) {
+            p1_wins++;
+        } else {
+            p2_wins++;
+        }
+    }
+
+    double elapsed = timer_seconds() - start;
+    if (recording && !replay_writer_close(&replay)) {
+        return -1;
+    }
+    if (elapsed <= 0) {
+        elapsed = 1e-9;
+    }
+
+    printf("headless: %d matches, %lld points, %lld ticks in %.3f s (%s physics)\n", options->matches, points, ticks,
+           elapsed, options->physics == PHYSICS_FIXED ? "fixed-point" : "float");
+    printf("  %.1f matches/sec, %.0f ticks/sec\n", options->matches / elapsed, ticks / elapsed);
+    printf("  p1 wins %d, p2 wins %d, %d rally timeouts\n", p1_wins, p2_wins, timeouts);
+
+    return 0;
+}
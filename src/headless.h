@@ -0,0 +1,64 @@
+#pragma once
+
+#include "ai.h"
+#include "replay.h"
+#include "sim.h"
+#include "sim_fixed.h"
+
+typedef enum {
+    PLAYER_AI,
+    PLAYER_SCRIPT,
+    // Predicts where the ball will cross, see ai.h
+    PLAYER_CPU,
+} PlayerKind;
+
+typedef struct {
+    PlayerKind kind;
+    // How far off the AI aims, as a fraction of the paddle height. Above 1.0
+    // it starts missing balls.
+    float aim_error;
+    // How long a CPU player takes to notice the ball changed direction
+    float reaction_time;
+} PlayerProfile;
+
+typedef struct {
+    int p1_score;
+    int p2_score;
+    int points;
+    int timeouts;
+    int hits;
+    int longest_rally;
+    long long ticks;
+    float duration;
+} MatchResult;
+
+typedef struct {
+    int matches;
+    uint64_t seed;
+    float dt;
+    PlayerKind p1;
+    PlayerKind p2;
+    // For players of PLAYER_CPU kind
+    AiDifficulty cpu;
+    // Every match goes into this one replay file when set
+    const char *record_path;
+    PhysicsBackend physics;
+} HeadlessOptions;
+
+#define HEADLESS_DEFAULT_DT (1.0f / 120.0f)
+#define DEFAULT_AIM_ERROR 1.2f
+
+// A point that runs this long (e.g. a ball served almost vertically) is
+// re-served so scripted matches always terminate.
+#define HEADLESS_RALLY_TIMEOUT 60.0f
+
+bool parse_player_kind(const char *name, PlayerKind *kind);
+int8_t headless_player_input(PlayerKind kind, const Match *match, bool is_left_side, float aim_offset, float match_time);
+
+// Plays one match to WINNING_SCORE. Everything random comes from seed, so the
+// same seed always gives the same result. Each tick is recorded into replay
+// unless it is NULL; only the float backend can be recorded.
+void play_match(uint64_t seed, const PlayerProfile *p1, const PlayerProfile *p2, float dt, PhysicsBackend physics,
+                MatchResult *result, ReplayWriter *replay);
+
+int run_headless(const HeadlessOptions *options);
@@ -0,0 +1,78 @@
+#include "latency_probe.h"
+
+#include "sim.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+static Uint64 random_interval(LatencyProbe *probe) {
+    // Irregular, so the flips don't lock to the tick or refresh phase
+    const int span = PROBE_MAX_INTERVAL_MS - PROBE_MIN_INTERVAL_MS;
+    int ms = PROBE_MIN_INTERVAL_MS + (int)(random_u64(&probe->rng) % (span + 1));
+    return SDL_GetPerformanceFrequency() * ms / 1000;
+}
+
+void latency_probe_start(LatencyProbe *probe, float seconds) {
+    Uint64 now = SDL_GetPerformanceCounter();
+
+    *probe = (LatencyProbe){
+        .isEnabled = true,
+        .end = now + (Uint64)(seconds * SDL_GetPerformanceFrequency()),
+        .rng = 1,
+        .direction = -1,
+    };
+    probe->next_flip = now + random_interval(probe);
+}
+
+bool latency_probe_update(LatencyProbe *probe, Uint64 now) {
+    if (now >= probe->end) {
+        return false;
+    }
+
+    if (now >= probe->next_flip) {
+        probe->direction = -probe->direction;
+        probe->sequence++;
+        probe->flip_times[probe->sequence % PROBE_HISTORY] = now;
+        probe->next_flip = now + random_interval(probe);
+    }
+    return true;
+}
+
+void latency_probe_shown(LatencyProbe *probe, uint32_t sequence, Uint64 now) {
+    if (sequence == probe->last_shown) {
+        return;
+    }
+    probe->last_shown = sequence;
+
+    if (probe->sample_count < PROBE_MAX_SAMPLES) {
+        Uint64 flip_time = probe->flip_times[sequence % PROBE_HISTORY];
+        probe->samples[probe->sample_count++] = (float)((now - flip_time) * 1000.0 / SDL_GetPerformanceFrequency());
+    }
+}
+
+static int compare_floats(const void *a, const void *b) {
+    float x = *(const float *)a;
+    float y = *(const float *)b;
+    return (x > y) - (x < y);
+}
+
+void latency_probe_report(const LatencyProbe *probe, const char *design) {
+    int count = probe->sample_count;
+    if (count == 0) {
+        printf("latency (%s): no samples\n", design);
+        return;
+    }
+
+    float sorted[PROBE_MAX_SAMPLES];
+    SDL_memcpy(sorted, probe->samples, count * sizeof(float));
+    qsort(sorted, count, sizeof(float), compare_floats);
+
+    double sum = 0;
+    for (int i = 0; i < count; i++) {
+        sum += sorted[i];
+    }
+
+    printf("latency (%s): %d samples, input to photon mean %.2f ms, p50 %.2f, p95 %.2f, p99 %.2f, max %.2f\n", design,
+           count, sum / count, sorted[(count - 1) * 50 / 100], sorted[(count - 1) * 95 / 100],
+           sorted[(count - 1) * 99 / 100], sorted[count - 1]);
+}
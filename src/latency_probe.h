@@ -0,0 +1,38 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+
+#include <stdbool.h>
+
+// Measures input-to-photon latency without a human: player 1's input is
+// flipped between up and down at irregular intervals, and each flip is timed
+// from when the main thread hands it to the simulation until SDL_RenderPresent
+// returns with the first frame drawn from a tick that used it.
+
+#define PROBE_MIN_INTERVAL_MS 150
+#define PROBE_MAX_INTERVAL_MS 250
+// Flips in flight at once; far more than can be between input and display
+#define PROBE_HISTORY 64
+#define PROBE_MAX_SAMPLES 4096
+
+typedef struct {
+    bool isEnabled;
+    Uint64 end;
+    Uint64 next_flip;
+    uint64_t rng;
+
+    int8_t direction;
+    uint32_t sequence;
+    Uint64 flip_times[PROBE_HISTORY];
+    uint32_t last_shown;
+
+    float samples[PROBE_MAX_SAMPLES];
+    int sample_count;
+} LatencyProbe;
+
+void latency_probe_start(LatencyProbe *probe, float seconds);
+// Flips the probe input when it is due. Returns false once the run is over.
+bool latency_probe_update(LatencyProbe *probe, Uint64 now);
+// Call after presenting a frame drawn from a tick that used input `sequence`
+void latency_probe_shown(LatencyProbe *probe, uint32_t sequence, Uint64 now);
+void latency_probe_report(const LatencyProbe *probe, const char *design);
@@ -0,0 +1,359 @@
+#include "headless.h"
+#include "net.h"
+#include "rollback.h"
+#include "timer.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Two rollback peers in one process, talking real UDP over localhost. Every
+// packet waits in a simulated link first, which adds latency and jitter and
+// drops some, so a minute of bad network runs in well under a second. Both
+// peers are AI players acting on their own, possibly mispredicted, view.
+
+// Packets in flight per direction; far more than latency can queue
+#define LINK_CAPACITY 1024
+#define LATENCY_HISTORY ROLLBACK_INPUT_HISTORY
+
+typedef struct {
+    float latency_ms;
+    float jitter_ms;
+    float loss;
+    int input_delay;
+    float seconds;
+    float dt;
+    uint64_t seed;
+} LoopbackOptions;
+
+typedef struct {
+    double deliver_at;
+    int size;
+    uint8_t data[ROLLBACK_MAX_PACKET];
+} Packet;
+
+// One direction of the simulated network
+typedef struct {
+    Packet packets[LINK_CAPACITY];
+    int count;
+    long long sent;
+    long long dropped;
+} Link;
+
+typedef struct {
+    RollbackSession session;
+    NetSocket sock;
+    NetAddress address;
+    Link outgoing;
+
+    uint64_t rng;
+    float aim;
+    bool heading_left;
+
+    // When each local input was given, to time how long the other side takes to show it
+    double given_at[LATENCY_HISTORY];
+
+    double *advance_us;
+    float *perceived_ms;
+    int perceived_count;
+} Peer;
+
+static void print_usage(const char *program) {
+    fprintf(stderr,
+            "Usage: %s [--latency MS] [--jitter MS] [--loss PERCENT] [--input-delay FRAMES] [--seconds S]"
+            " [--dt SECONDS] [--seed S]\n",
+            program);
+}
+
+static void link_push(Link *link, const LoopbackOptions *options, uint64_t *rng, double now, const uint8_t *data,
+                      int size) {
+    link->sent++;
+    if (random_float(rng) < options->loss || link->count == LINK_CAPACITY) {
+        link->dropped++;
+        return;
+    }
+
+    // Uniform jitter around the latency, so packets also arrive out of order
+    double delay = (options->latency_ms + (random_float(rng) * 2 - 1) * options->jitter_ms) / 1000.0;
+    Packet *packet = &link->packets[link->count++];
+    packet->deliver_at = now + (delay > 0 ? delay : 0);
+    packet->size = size;
+    memcpy(packet->data, data, size);
+}
+
+// Hands every packet that is due to the real socket
+static void link_deliver(Link *link, const NetSocket *from, const NetAddress *to, double now) {
+    for (int i = 0; i < link->count;) {
+        if (link->packets[i].deliver_at <= now) {
+            net_send(from, to, link->packets[i].data, link->packets[i].size);
+            link->packets[i] = link->packets[--link->count];
+        } else {
+            i++;
+        }
+    }
+}
+
+static void receive_packets(Peer *peer, const Peer *other, double now) {
+    RollbackSession *session = &peer->session;
+    int remote = 1 - session->local;
+    uint8_t packet[ROLLBACK_MAX_PACKET];
+    int size;
+
+    while ((size = net_receive(&peer->sock, NULL, packet, sizeof(packet))) >= 0) {
+        uint32_t confirmed = session->remote_frames;
+        if (!rollback_read_packet(session, packet, size)) {
+            continue;
+        }
+
+        // A remote press is seen once the frame it applies to is shown with
+        // it: now if that frame was already predicted, later if not. Holding
+        // a direction isn't noticeable, so only changes count.
+        for (uint32_t f = confirmed; f < session->remote_frames; f++) {
+            uint8_t input = session->inputs[remote][f % ROLLBACK_INPUT_HISTORY];
+            if (f == 0 || input == session->inputs[remote][(f - 1) % ROLLBACK_INPUT_HISTORY]) {
+                continue;
+            }
+            double shown = f < session->frame ? now : now + (f - session->frame) * session->dt;
+            peer->perceived_ms[peer->perceived_count++] = (float)((shown - other->given_at[f % LATENCY_HISTORY]) * 1000);
+        }
+    }
+}
+
+static MatchInput choose_input(Peer *peer) {
+    const Match *match = &peer->session.match;
+    bool is_left_side = peer->session.local == 0;
+
+    if ((match->ball.dir.x < 0) != peer->heading_left) {
+        peer->heading_left = match->ball.dir.x < 0;
+        peer->aim = (random_float(&peer->rng) - 0.5f) * DEFAULT_AIM_ERROR * PADDLE_HEIGHT;
+    }
+
+    int8_t direction = headless_player_input(PLAYER_AI, match, is_left_side, peer->aim, peer->session.total_time);
+    return (MatchInput){
+        .p1 = is_left_side ? direction : 0,
+        .p2 = is_left_side ? 0 : direction,
+        .serve = !match->hasStarted,
+    };
+}
+
+static bool same_match(const Match *a, const Match *b) {
+    const Paddle *pa[2] = {&a->p1, &a->p2};
+    const Paddle *pb[2] = {&b->p1, &b->p2};
+    for (int i = 0; i < 2; i++) {
+        if (pa[i]->pos.x != pb[i]->pos.x || pa[i]->pos.y != pb[i]->pos.y || pa[i]->score != pb[i]->score) {
+            return false;
+        }
+    }
+    return a->ball.pos.x == b->ball.pos.x && a->ball.pos.y == b->ball.pos.y && a->ball.dir.x == b->ball.dir.x &&
+           a->ball.dir.y == b->ball.dir.y && a->ball.speed == b->ball.speed && a->hasStarted == b->hasStarted &&
+           a->rng == b->rng;
+}
+
+static int compare_doubles(const void *a, const void *b) {
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static int compare_floats(const void *a, const void *b) {
+    float x = *(const float *)a;
+    float y = *(const float *)b;
+    return (x > y) - (x < y);
+}
+
+static void report_peer(const Peer *peer, const LoopbackOptions *options) {
+    const RollbackStats *s = &peer->session.stats;
+    if (s->frames == 0) {
+        printf("player %d: no frames simulated\n", peer->session.local + 1);
+        return;
+    }
+    long long frames = s->frames;
+
+    printf("player %d\n", peer->session.local + 1);
+    printf("  frames %lld, stalls %lld, packets sent %lld, dropped %lld\n", s->frames, s->stalls,
+           peer->outgoing.sent, peer->outgoing.dropped);
+    printf("  rollbacks %lld (%.1f%% of frames), mispredicted inputs %lld, predicted frames %.1f%%\n", s->rollbacks,
+           100.0 * s->rollbacks / frames, s->mispredicted, 100.0 * s->predicted / frames);
+    printf("  resimulated %lld frames: %.2f per frame, %.1f per rollback, max %d\n", s->resimulated,
+           (double)s->resimulated / frames, s->rollbacks > 0 ? (double)s->resimulated / s->rollbacks : 0.0,
+           s->max_rollback);
+
+    // Simulation cost per frame, including any resimulation
+    double *sorted = malloc(s->frames * sizeof(double));
+    memcpy(sorted, peer->advance_us, s->frames * sizeof(double));
+    qsort(sorted, s->frames, sizeof(double), compare_doubles);
+    double sum = 0;
+    for (long long i = 0; i < s->frames; i++) {
+        sum += sorted[i];
+    }
+    printf("  advance cost mean %.2f us, p99 %.2f, max %.2f\n", sum / frames, sorted[(s->frames - 1) * 99 / 100],
+           sorted[s->frames - 1]);
+    free(sorted);
+
+    printf("  perceived latency: own input %.1f ms", options->input_delay * options->dt * 1000);
+    int count = peer->perceived_count;
+    if (count == 0) {
+        printf(", opponent no samples\n");
+        return;
+    }
+    qsort(peer->perceived_ms, count, sizeof(float), compare_floats);
+    double total = 0;
+    for (int i = 0; i < count; i++) {
+        total += peer->perceived_ms[i];
+    }
+    printf(", opponent mean %.1f ms, p50 %.1f, p95 %.1f, max %.1f (%d presses)\n", total / count,
+           peer->perceived_ms[(count - 1) / 2], peer->perceived_ms[(count - 1) * 95 / 100], peer->perceived_ms[count - 1],
+           count);
+}
+
+static int run_loopback(const LoopbackOptions *options) {
+    long long max_frames = (long long)ceilf(options->seconds / options->dt);
+    Peer *peers = calloc(2, sizeof(Peer));
+    if (peers == NULL) {
+        return -1;
+    }
+
+    for (int i = 0; i < 2; i++) {
+        Peer *peer = &peers[i];
+        rollback_init(&peer->session, options->seed, i, options->input_delay, options->dt);
+        peer->rng = options->seed + 1 + i;
+        peer->heading_left = peer->session.match.ball.dir.x >= 0;
+        peer->advance_us = malloc(max_frames * sizeof(double));
+        peer->perceived_ms = malloc((max_frames + options->input_delay) * sizeof(float));
+
+        if (!net_open(&peer->sock, 0) || !net_local_address(&peer->sock, &peer->address) ||
+            peer->advance_us == NULL || peer->perceived_ms == NULL) {
+            fprintf(stderr, "Unable to set up player %d\n", i + 1);
+            return -1;
+        }
+        peer->address.host = NET_LOOPBACK;
+    }
+
+    uint64_t link_rng = options->seed;
+    long long checked = 0;
+    long long desyncs = 0;
+    uint32_t last_checked = 0;
+
+    for (long long tick = 0; tick < max_frames; tick++) {
+        double now = tick * options->dt;
+
+        for (int i = 0; i < 2; i++) {
+            Peer *peer = &peers[i];
+            Peer *other = &peers[1 - i];
+            RollbackSession *session = &peer->session;
+
+            link_deliver(&other->outgoing, &other->sock, &peer->address, now);
+            receive_packets(peer, other, now);
+
+            // The input lands on frame local_frames, input_delay frames from now
+            MatchInput input = choose_input(peer);
+            peer->given_at[session->local_frames % LATENCY_HISTORY] = now;
+
+            double start = timer_seconds();
+            if (rollback_advance(session, input) >= 0) {
+                peer->advance_us[session->stats.frames - 1] = (timer_seconds() - start) * 1e6;
+            }
+
+            uint8_t packet[ROLLBACK_MAX_PACKET];
+            size_t size = rollback_write_packet(session, packet);
+            link_push(&peer->outgoing, options, &link_rng, now, packet, (int)size);
+        }
+
+        // Once both sides have every input up to a frame, they must agree on it
+        uint32_t agreed = UINT32_MAX;
+        for (int i = 0; i < 2; i++) {
+            const RollbackSession *session = &peers[i].session;
+            uint32_t confirmed = session->remote_frames < session->frame ? session->remote_frames : session->frame;
+            if (session->rollback_from < confirmed) {
+                confirmed = session->rollback_from;
+            }
+            if (confirmed < agreed) {
+                agreed = confirmed;
+            }
+        }
+        if (agreed > last_checked && peers[0].session.frame - agreed < ROLLBACK_WINDOW &&
+            peers[1].session.frame - agreed < ROLLBACK_WINDOW) {
+            const Match *a = &peers[0].session.states[agreed % ROLLBACK_WINDOW];
+            const Match *b = &peers[1].session.states[agreed % ROLLBACK_WINDOW];
+            if (agreed == peers[0].session.frame) {
+                a = &peers[0].session.match;
+            }
+            if (agreed == peers[1].session.frame) {
+                b = &peers[1].session.match;
+            }
+            if (!same_match(a, b)) {
+                desyncs++;
+            }
+            checked++;
+            last_checked = agreed;
+        }
+    }
+
+    printf("loopback: %.0f s at %.0f Hz, latency %.0f ms, jitter %.0f ms, loss %.1f%%, input delay %d frames\n",
+           options->seconds, 1 / options->dt, options->latency_ms, options->jitter_ms, options->loss * 100,
+           options->input_delay);
+    for (int i = 0; i < 2; i++) {
+        report_peer(&peers[i], options);
+    }
+    const Match *match = &peers[0].session.match;
+    printf("score %d-%d, %lld confirmed frames compared, %lld desyncs\n", match->p1.score, match->p2.score, checked,
+           desyncs);
+
+    for (int i = 0; i < 2; i++) {
+        net_close(&peers[i].sock);
+        free(peers[i].advance_us);
+        free(peers[i].perceived_ms);
+    }
+    free(peers);
+    return desyncs == 0 ? 0 : -1;
+}
+
+int main(int argc, char **argv) {
+    LoopbackOptions options = {
+        .latency_ms = 50,
+        .jitter_ms = 10,
+        .loss = 0.02f,
+        .input_delay = DEFAULT_INPUT_DELAY,
+        .seconds = 60,
+        .dt = HEADLESS_DEFAULT_DT,
+        .seed = 1,
+    };
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        bool has_value = i + 1 < argc;
+
+        if (strcmp(arg, "--latency") == 0 && has_value) {
+            options.latency_ms = strtof(argv[++i], NULL);
+        } else if (strcmp(arg, "--jitter") == 0 && has_value) {
+            options.jitter_ms = strtof(argv[++i], NULL);
+        } else if (strcmp(arg, "--loss") == 0 && has_value) {
+            options.loss = strtof(argv[++i], NULL) / 100;
+        } else if (strcmp(arg, "--input-delay") == 0 && has_value) {
+            options.input_delay = atoi(argv[++i]);
+        } else if (strcmp(arg, "--seconds") == 0 && has_value) {
+            options.seconds = strtof(argv[++i], NULL);
+        } else if (strcmp(arg, "--dt") == 0 && has_value) {
+            options.dt = strtof(argv[++i], NULL);
+        } else if (strcmp(arg, "--seed") == 0 && has_value) {
+            options.seed = strtoull(argv[++i], NULL, 10);
+        } else {
+            print_usage(argv[0]);
+            return -1;
+        }
+    }
+
+    if (options.latency_ms < 0 || options.jitter_ms < 0 || options.loss < 0 || options.loss >= 1 ||
+        options.input_delay < 0 || options.input_delay >= ROLLBACK_WINDOW || options.seconds <= 0 || options.dt <= 0) {
+        fprintf(stderr, "Invalid network or timing options\n");
+        return -1;
+    }
+
+    if (!net_init()) {
+        return -1;
+    }
+    int result = run_loopback(&options);
+    net_shutdown();
+    return result;
+}
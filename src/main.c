@@ -1,12 +1,174 @@
 #include "game.h"
+#include "headless.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static void print_usage(const char *program) {
+    fprintf(stderr,
+            "Usage: %s [--tick-rate HZ] [--fps N] [--pacing vsync|sleep|uncapped] [--threaded] [--measure-latency SECONDS]"
+            " [--record FILE] [--seed S] [--cpu easy|normal|hard] [--balls N] [--startup-trace]\n"
+            "       %s (--capture FILE|- | --compare FILE) [--capture-format y4m|rgba] [--capture-frames N]"
+            " [--capture-async] [--seed S] [--cpu easy|normal|hard] [--balls N] [--tick-rate HZ] [--fps N]\n"
+            "       %s (--host PORT | --join HOST:PORT) [--input-delay FRAMES] [--seed S] [--tick-rate HZ] [--fps N]\n"
+            "       %s --headless [--matches N] [--seed S] [--dt SECONDS] [--p1 ai|script|cpu] [--p2 ai|script|cpu]"
+            " [--cpu easy|normal|hard] [--record FILE]\n",
+            program, program, program, program);
+}
 
 int main(int argc, char **argv) {
-    if (!init()) {
+    // Startup is timed from here
+    const Uint64 start_counts = SDL_GetPerformanceCounter();
+    bool headless = false;
+    HeadlessOptions headless_options = {
+        .matches = 100,
+        .seed = 1,
+        .dt = HEADLESS_DEFAULT_DT,
+        .p1 = PLAYER_AI,
+        .p2 = PLAYER_AI,
+        .physics = DEFAULT_PHYSICS,
+        .cpu = AI_NORMAL,
+    };
+    GameOptions game_options = {
+        .tick_rate = DEFAULT_TICK_RATE,
+        .frame_rate = DEFAULT_FRAME_RATE,
+        .pacing = PACING_VSYNC,
+        .seed = 1,
+        .input_delay = DEFAULT_INPUT_DELAY,
+        .cpu = AI_NORMAL,
+        .capture_format = CAPTURE_Y4M,
+        .capture_frames = CAPTURE_DEFAULT_FRAMES,
+        .start_counts = start_counts,
+    };
+    bool has_seed = false;
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        bool has_value = i + 1 < argc;
+
+        if (strcmp(arg, "--headless") == 0) {
+            headless = true;
+        } else if (strcmp(arg, "--matches") == 0 && has_value) {
+            headless_options.matches = atoi(argv[++i]);
+        } else if (strcmp(arg, "--seed") == 0 && has_value) {
+            headless_options.seed = strtoull(argv[++i], NULL, 10);
+            game_options.seed = headless_options.seed;
+            has_seed = true;
+        } else if (strcmp(arg, "--dt") == 0 && has_value) {
+            headless_options.dt = strtof(argv[++i], NULL);
+        } else if (strcmp(arg, "--p1") == 0 && has_value && parse_player_kind(argv[i + 1], &headless_options.p1)) {
+            i++;
+        } else if (strcmp(arg, "--p2") == 0 && has_value && parse_player_kind(argv[i + 1], &headless_options.p2)) {
+            i++;
+        } else if (strcmp(arg, "--cpu") == 0 && has_value && parse_ai_difficulty(argv[i + 1], &game_options.cpu)) {
+            // Plays player 2 in the game; sets how well cpu players play headless
+            headless_options.cpu = game_options.cpu;
+            game_options.cpu_opponent = true;
+            i++;
+        } else if (strcmp(arg, "--balls") == 0 && has_value) {
+            game_options.stress_balls = atoi(argv[++i]);
+        } else if (strcmp(arg, "--capture") == 0 && has_value) {
+            game_options.capture_path = argv[++i];
+        } else if (strcmp(arg, "--compare") == 0 && has_value) {
+            game_options.compare_path = argv[++i];
+        } else if (strcmp(arg, "--capture-format") == 0 && has_value &&
+                   parse_capture_format(argv[i + 1], &game_options.capture_format)) {
+            i++;
+        } else if (strcmp(arg, "--capture-frames") == 0 && has_value) {
+            game_options.capture_frames = atoi(argv[++i]);
+        } else if (strcmp(arg, "--capture-async") == 0) {
+            game_options.capture_async = true;
+        } else if (strcmp(arg, "--tick-rate") == 0 && has_value) {
+            game_options.tick_rate = atoi(argv[++i]);
+        } else if (strcmp(arg, "--fps") == 0 && has_value) {
+            game_options.frame_rate = atoi(argv[++i]);
+        } else if (strcmp(arg, "--pacing") == 0 && has_value && parse_pacing_mode(argv[i + 1], &game_options.pacing)) {
+            i++;
+#ifdef PONG_PROFILER
+        } else if (strcmp(arg, "--profile-out") == 0 && has_value) {
+            game_options.profile_path = argv[++i];
+#endif
+        } else if (strcmp(arg, "--startup-trace") == 0) {
+            game_options.startup_trace = true;
+        } else if (strcmp(arg, "--threaded") == 0) {
+            game_options.threaded = true;
+        } else if (strcmp(arg, "--measure-latency") == 0 && has_value) {
+            game_options.latency_seconds = strtof(argv[++i], NULL);
+        } else if (strcmp(arg, "--host") == 0 && has_value) {
+            game_options.host_port = (uint16_t)atoi(argv[++i]);
+        } else if (strcmp(arg, "--join") == 0 && has_value) {
+            game_options.join_address = argv[++i];
+        } else if (strcmp(arg, "--input-delay") == 0 && has_value) {
+            game_options.input_delay = atoi(argv[++i]);
+        } else if (strcmp(arg, "--record") == 0 && has_value) {
+            headless_options.record_path = argv[++i];
+            game_options.record_path = argv[i];
+        } else {
+            print_usage(argv[0]);
+            return -1;
+        }
+    }
+
+    if (headless) {
+        if (headless_options.matches <= 0 || headless_options.dt <= 0) {
+            ERROR_RETURN(-1, "--matches and --dt must be positive\n");
+        }
+        return run_headless(&headless_options);
+    }
+
+    if (game_options.tick_rate <= 0 || game_options.frame_rate <= 0) {
+        ERROR_RETURN(-1, "--tick-rate and --fps must be positive\n");
+    }
+    if (game_options.stress_balls < 0 || game_options.stress_balls > SWARM_MAX_BALLS) {
+        ERROR_RETURN(-1, "--balls must be between 0 (off) and %d\n", SWARM_MAX_BALLS);
+    }
+    if (game_options.stress_balls > 0 && game_options.threaded) {
+        ERROR_RETURN(-1, "--balls steps the balls between frames; it can't be combined with --threaded\n");
+    }
+
+    bool capturing = game_options.capture_path != NULL || game_options.compare_path != NULL;
+    if (capturing) {
+        if (game_options.capture_frames <= 0) {
+            ERROR_RETURN(-1, "--capture-frames must be positive\n");
+        }
+        if (game_options.threaded || game_options.latency_seconds > 0) {
+            ERROR_RETURN(-1, "--capture renders frame by frame; it can't be combined with --threaded or "
+                             "--measure-latency\n");
+        }
+        // Both paddles are the computer's
+        game_options.cpu_opponent = true;
+    }
+
+    bool online = game_options.host_port != 0 || game_options.join_address != NULL;
+    if (online) {
+        if (game_options.host_port != 0 && game_options.join_address != NULL) {
+            ERROR_RETURN(-1, "--host and --join are mutually exclusive\n");
+        }
+        if (game_options.threaded || game_options.record_path != NULL || game_options.latency_seconds > 0 ||
+            game_options.cpu_opponent || game_options.stress_balls != 0 || capturing) {
+            ERROR_RETURN(-1, "--threaded, --record, --measure-latency, --cpu, --balls and --capture are for local "
+                             "play only\n");
+        }
+        if (game_options.input_delay < 0 || game_options.input_delay >= ROLLBACK_WINDOW) {
+            ERROR_RETURN(-1, "--input-delay must be between 0 and %d\n", ROLLBACK_WINDOW - 1);
+        }
+    } else if (!has_seed && !capturing) {
+        // Online matches and captures default to the same seed every time; local play varies
+        game_options.seed = time(NULL);
+    }
+
+    if (!init(&game_options)) {
         ERROR_RETURN(-1, "Failed to init SDL2\n");
     }
 
-    game_loop();
+    bool ok = true;
+    if (capturing) {
+        ok = capture_loop();
+    } else {
+        game_loop();
+    }
 
     cleanup();
-    return 0;
+    return ok ? 0 : 1;
 }
@@ -0,0 +1,151 @@
+#include "net.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+typedef int socklen_t;
+#define INVALID_HANDLE ((uintptr_t)INVALID_SOCKET)
+#else
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#define INVALID_HANDLE (-1)
+#endif
+
+bool net_init() {
+#ifdef _WIN32
+    WSADATA data;
+    if (WSAStartup(MAKEWORD(2, 2), &data) != 0) {
+        fprintf(stderr, "Unable to start Winsock\n");
+        return false;
+    }
+#endif
+    return true;
+}
+
+void net_shutdown() {
+#ifdef _WIN32
+    WSACleanup();
+#endif
+}
+
+static struct sockaddr_in to_sockaddr(const NetAddress *address) {
+    struct sockaddr_in addr = {0};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(address->host);
+    addr.sin_port = htons(address->port);
+    return addr;
+}
+
+bool net_open(NetSocket *sock, uint16_t port) {
+    sock->handle = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (sock->handle == INVALID_HANDLE) {
+        fprintf(stderr, "Unable to create a UDP socket\n");
+        return false;
+    }
+
+    NetAddress any = {.host = INADDR_ANY, .port = port};
+    struct sockaddr_in addr = to_sockaddr(&any);
+    if (bind(sock->handle, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        fprintf(stderr, "Unable to bind UDP port %u\n", port);
+        net_close(sock);
+        return false;
+    }
+
+#ifdef _WIN32
+    u_long non_blocking = 1;
+    bool ok = ioctlsocket(sock->handle, FIONBIO, &non_blocking) == 0;
+#else
+    bool ok = fcntl(sock->handle, F_SETFL, fcntl(sock->handle, F_GETFL) | O_NONBLOCK) == 0;
+#endif
+    if (!ok) {
+        fprintf(stderr, "Unable to make the UDP socket non-blocking\n");
+        net_close(sock);
+        return false;
+    }
+    return true;
+}
+
+void net_close(NetSocket *sock) {
+    if (sock->handle == INVALID_HANDLE) {
+        return;
+    }
+#ifdef _WIN32
+    closesocket(sock->handle);
+#else
+    close(sock->handle);
+#endif
+    sock->handle = INVALID_HANDLE;
+}
+
+bool net_local_address(const NetSocket *sock, NetAddress *address) {
+    struct sockaddr_in addr;
+    socklen_t length = sizeof(addr);
+    if (getsockname(sock->handle, (struct sockaddr *)&addr, &length) != 0) {
+        return false;
+    }
+    address->host = ntohl(addr.sin_addr.s_addr);
+    address->port = ntohs(addr.sin_port);
+    return true;
+}
+
+bool net_resolve(const char *host_port, NetAddress *address) {
+    const char *colon = strrchr(host_port, ':');
+    if (colon == NULL || colon == host_port) {
+        fprintf(stderr, "Expected host:port, got '%s'\n", host_port);
+        return false;
+    }
+
+    char *end;
+    long port = strtol(colon + 1, &end, 10);
+    if (*end != '\0' || port <= 0 || port > 65535) {
+        fprintf(stderr, "Invalid port in '%s'\n", host_port);
+        return false;
+    }
+
+    char host[256];
+    size_t length = (size_t)(colon - host_port);
+    if (length >= sizeof(host)) {
+        fprintf(stderr, "Host name too long: '%s'\n", host_port);
+        return false;
+    }
+    memcpy(host, host_port, length);
+    host[length] = '\0';
+
+    struct addrinfo hints = {.ai_family = AF_INET, .ai_socktype = SOCK_DGRAM};
+    struct addrinfo *result;
+    if (getaddrinfo(host, NULL, &hints, &result) != 0) {
+        fprintf(stderr, "Unable to resolve '%s'\n", host);
+        return false;
+    }
+    address->host = ntohl(((struct sockaddr_in *)result->ai_addr)->sin_addr.s_addr);
+    address->port = (uint16_t)port;
+    freeaddrinfo(result);
+    return true;
+}
+
+bool net_send(const NetSocket *sock, const NetAddress *to, const void *data, int size) {
+    struct sockaddr_in addr = to_sockaddr(to);
+    return sendto(sock->handle, data, size, 0, (struct sockaddr *)&addr, sizeof(addr)) == size;
+}
+
+int net_receive(const NetSocket *sock, NetAddress *from, void *buffer, int capacity) {
+    struct sockaddr_in addr;
+    socklen_t length = sizeof(addr);
+    int size = (int)recvfrom(sock->handle, buffer, capacity, 0, (struct sockaddr *)&addr, &length);
+    if (size < 0) {
+        return -1;
+    }
+    if (from != NULL) {
+        from->host = ntohl(addr.sin_addr.s_addr);
+        from->port = ntohs(addr.sin_port);
+    }
+    return size;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Minimal non-blocking IPv4 UDP, over BSD sockets or Winsock
+
+typedef struct {
+#ifdef _WIN32
+    uintptr_t handle;
+#else
+    int handle;
+#endif
+} NetSocket;
+
+#define NET_LOOPBACK 0x7f000001 // 127.0.0.1
+
+// Host byte order
+typedef struct {
+    uint32_t host;
+    uint16_t port;
+} NetAddress;
+
+bool net_init();
+void net_shutdown();
+
+// Binds to port on all interfaces; port 0 picks a free one
+bool net_open(NetSocket *sock, uint16_t port);
+void net_close(NetSocket *sock);
+bool net_local_address(const NetSocket *sock, NetAddress *address);
+
+// "host:port", with host a name or dotted quad
+bool net_resolve(const char *host_port, NetAddress *address);
+
+bool net_send(const NetSocket *sock, const NetAddress *to, const void *data, int size);
+// Size of the datagram received, or -1 when there is none waiting
+int net_receive(const NetSocket *sock, NetAddress *from, void *buffer, int capacity);
@@ -0,0 +1,154 @@
+#include "profiler.h"
+
+#ifdef PONG_PROFILER
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    Uint64 start;
+    Uint64 end;
+    ProfilePhase phase;
+} ProfileEvent;
+
+typedef struct {
+    ProfileEvent events[PROFILE_EVENT_CAPACITY];
+    long long event_count;
+
+    // Time spent in each phase this frame (ticks can run several times a frame)
+    Uint64 current[PHASE_COUNT];
+    float window[PHASE_COUNT][PROFILE_WINDOW];
+    long long frame_count;
+
+    bool showOverlay;
+    char overlay[PHASE_COUNT][5][16];
+} Profiler;
+
+static Profiler profiler;
+
+static const char *phase_names[PHASE_COUNT] = {"events", "input", "update", "render", "present", "frame"};
+
+void profiler_record(ProfilePhase phase, Uint64 start, Uint64 end) {
+    profiler.events[profiler.event_count % PROFILE_EVENT_CAPACITY] = (ProfileEvent){start, end, phase};
+    profiler.event_count++;
+    profiler.current[phase] += end - start;
+}
+
+static int compare_floats(const void *a, const void *b) {
+    float x = *(const float *)a;
+    float y = *(const float *)b;
+    return (x > y) - (x < y);
+}
+
+static void update_overlay() {
+    const int percentiles[] = {50, 95, 99, 100};
+    int frames = profiler.frame_count < PROFILE_WINDOW ? (int)profiler.frame_count : PROFILE_WINDOW;
+    float sorted[PROFILE_WINDOW];
+
+    for (int phase = 0; phase < PHASE_COUNT; phase++) {
+        memcpy(sorted, profiler.window[phase], frames * sizeof(float));
+        qsort(sorted, frames, sizeof(float), compare_floats);
+
+        snprintf(profiler.overlay[phase][0], sizeof(profiler.overlay[phase][0]), "%s", phase_names[phase]);
+        for (int i = 0; i < 4; i++) {
+            // Nearest rank; p100 is the max
+            int rank = (frames - 1) * percentiles[i] / 100;
+            snprintf(profiler.overlay[phase][i + 1], sizeof(profiler.overlay[phase][i + 1]), "%.3f", sorted[rank]);
+        }
+    }
+}
+
+void profiler_end_frame(Uint64 frame_start, Uint64 frame_end) {
+    profiler_record(PHASE_FRAME, frame_start, frame_end);
+
+    const double ms_per_count = 1000.0 / SDL_GetPerformanceFrequency();
+    int slot = profiler.frame_count % PROFILE_WINDOW;
+    for (int phase = 0; phase < PHASE_COUNT; phase++) {
+        profiler.window[phase][slot] = (float)(profiler.current[phase] * ms_per_count);
+        profiler.current[phase] = 0;
+    }
+    profiler.frame_count++;
+
+    if (profiler.showOverlay && profiler.frame_count % PROFILE_OVERLAY_INTERVAL == 1) {
+        update_overlay();
+    }
+}
+
+void profiler_toggle_overlay() {
+    profiler.showOverlay = !profiler.showOverlay;
+    if (profiler.showOverlay && profiler.frame_count > 0) {
+        update_overlay();
+    }
+}
+
+void profiler_draw_overlay(RenderQueue *queue, const GlyphAtlas *atlas) {
+    if (!profiler.showOverlay || profiler.frame_count == 0) {
+        return;
+    }
+
+    const char *columns[] = {"ms", "p50", "p95", "p99", "max"};
+    const int column_x[] = {8, 110, 190, 270, 350};
+    const int line = atlas->line_height;
+    SDL_Color color = {0xFF, 0xFF, 0x00, 0xFF};
+
+    SDL_FRect background = {0, 0, 430, line * (PHASE_COUNT + 1) + 8};
+    push_rect(queue, LAYER_OVERLAY, background, (SDL_Color){0, 0, 0, 0xC0}, SDL_BLENDMODE_BLEND);
+
+    for (int column = 0; column < 5; column++) {
+        queue_text(queue, LAYER_OVERLAY_TEXT, atlas, columns[column], column_x[column], 4, color);
+    }
+    for (int phase = 0; phase < PHASE_COUNT; phase++) {
+        for (int column = 0; column < 5; column++) {
+            queue_text(queue, LAYER_OVERLAY_TEXT, atlas, profiler.overlay[phase][column], column_x[column],
+                       4 + line * (phase + 1), color);
+        }
+    }
+}
+
+bool profiler_dump(const char *path) {
+    FILE *file = fopen(path, "w");
+    if (file == NULL) {
+        fprintf(stderr, "Unable to open %s for the profile\n", path);
+        return false;
+    }
+
+    const char *extension = strrchr(path, '.');
+    bool trace = extension != NULL && strcmp(extension, ".json") == 0;
+    const double us_per_count = 1e6 / SDL_GetPerformanceFrequency();
+
+    // Oldest first; the ring only keeps the last PROFILE_EVENT_CAPACITY events
+    long long first = profiler.event_count > PROFILE_EVENT_CAPACITY ? profiler.event_count - PROFILE_EVENT_CAPACITY : 0;
+
+    // Frames are recorded after the phases inside them, so search for the earliest start
+    Uint64 origin = UINT64_MAX;
+    for (long long i = first; i < profiler.event_count; i++) {
+        Uint64 start = profiler.events[i % PROFILE_EVENT_CAPACITY].start;
+        origin = start < origin ? start : origin;
+    }
+
+    fprintf(file, trace ? "{\"traceEvents\":[\n" : "phase,start_us,duration_us\n");
+    for (long long i = first; i < profiler.event_count; i++) {
+        const ProfileEvent *e = &profiler.events[i % PROFILE_EVENT_CAPACITY];
+        double start = (e->start - origin) * us_per_count;
+        double duration = (e->end - e->start) * us_per_count;
+
+        if (trace) {
+            fprintf(file, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%.3f,\"dur\":%.3f}",
+                    i == first ? "" : ",\n", phase_names[e->phase], start, duration);
+        } else {
+            fprintf(file, "%s,%.3f,%.3f\n", phase_names[e->phase], start, duration);
+        }
+    }
+    if (trace) {
+        fprintf(file, "\n]}\n");
+    }
+
+    bool ok = fclose(file) == 0;
+    if (!ok) {
+        fprintf(stderr, "Unable to write the profile to %s\n", path);
+    }
+    return ok;
+}
+
+#endif
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+
+#include <stdbool.h>
+
+#include "glyph_atlas.h"
+#include "render_queue.h"
+
+// Per-phase frame timings. Only built with PONG_PROFILER defined (the
+// PONG_PROFILER CMake option); otherwise every PROFILE_* macro expands to
+// nothing and none of this is compiled in.
+
+typedef enum {
+    PHASE_EVENTS,
+    PHASE_INPUT,
+    PHASE_UPDATE,
+    PHASE_RENDER,
+    PHASE_PRESENT,
+    PHASE_FRAME,
+    PHASE_COUNT,
+} ProfilePhase;
+
+// Raw (phase, start, end) events kept for the trace dump
+#define PROFILE_EVENT_CAPACITY (1 << 16)
+// Frames the percentiles are taken over
+#define PROFILE_WINDOW 512
+// Frames between overlay refreshes, so the stats aren't re-sorted every frame
+#define PROFILE_OVERLAY_INTERVAL 30
+
+#ifdef PONG_PROFILER
+
+void profiler_record(ProfilePhase phase, Uint64 start, Uint64 end);
+void profiler_end_frame(Uint64 frame_start, Uint64 frame_end);
+void profiler_toggle_overlay();
+void profiler_draw_overlay(RenderQueue *queue, const GlyphAtlas *atlas);
+// Writes a Chrome trace (.json) or CSV (anything else) of the buffered events
+bool profiler_dump(const char *path);
+
+#define PROFILE_BEGIN(name) const Uint64 profile_##name = SDL_GetPerformanceCounter()
+#define PROFILE_END(name, phase) profiler_record(phase, profile_##name, SDL_GetPerformanceCounter())
+#define PROFILE_FRAME(start, end) profiler_end_frame(start, end)
+#define PROFILE_TOGGLE_OVERLAY() profiler_toggle_overlay()
+#define PROFILE_DRAW_OVERLAY(queue, atlas) profiler_draw_overlay(queue, atlas)
+
+#else
+
+#define PROFILE_BEGIN(name)
+#define PROFILE_END(name, phase)
+#define PROFILE_FRAME(start, end)
+#define PROFILE_TOGGLE_OVERLAY()
+#define PROFILE_DRAW_OVERLAY(queue, atlas)
+
+#endif
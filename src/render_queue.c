@@ -0,0 +1,282 @@
+#include "render_queue.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+void render_queue_init(RenderQueue *queue, SDL_Renderer *renderer) {
+    SDL_RendererInfo info;
+
+    queue->count = 0;
+    queue->dropped = 0;
+    queue->hasReportedDrops = false;
+    queue->prev_count = 0;
+    queue->bulk_count = 0;
+    queue->needsFullRedraw = true;
+    // Hardware back buffers are undefined after a present, so only software can patch the last frame
+    queue->useDirtyRects = SDL_GetRendererInfo(renderer, &info) == 0 && (info.flags & SDL_RENDERER_SOFTWARE);
+    queue->stats = (RenderStats){0};
+}
+
+void render_queue_begin(RenderQueue *queue, SDL_Color clear_color) {
+    queue->count = 0;
+    queue->dropped = 0;
+    queue->bulk_count = 0;
+    queue->clear_color = clear_color;
+}
+
+void render_queue_invalidate(RenderQueue *queue) {
+    queue->needsFullRedraw = true;
+}
+
+static void push_quad(RenderQueue *queue, RenderQuad quad) {
+    if (queue->count == RENDER_QUEUE_CAPACITY) {
+        queue->dropped++;
+        return;
+    }
+    quad.order = queue->count;
+    queue->quads[queue->count++] = quad;
+}
+
+void push_rect(RenderQueue *queue, RenderLayer layer, SDL_FRect dst, SDL_Color color, SDL_BlendMode blend) {
+    push_quad(queue, (RenderQuad){.dst = dst, .color = color, .blend = blend, .layer = layer});
+}
+
+void push_textured_quad(RenderQueue *queue, RenderLayer layer, SDL_Texture *texture, SDL_FRect dst, SDL_FRect uv,
+                        SDL_Color color) {
+    push_quad(queue, (RenderQuad){
+        .dst = dst,
+        .uv = uv,
+        .color = color,
+        .texture = texture,
+        .blend = SDL_BLENDMODE_BLEND,
+        .layer = layer,
+    });
+}
+
+void push_rect_array(RenderQueue *queue, RenderLayer layer, const SDL_FRect *rects, int count, SDL_Color color) {
+    queue->bulk_rects = rects;
+    queue->bulk_count = count;
+    queue->bulk_layer = layer;
+    queue->bulk_color = color;
+}
+
+static bool same_state(const RenderQuad *a, const RenderQuad *b) {
+    return a->layer == b->layer && a->texture == b->texture && a->blend == b->blend;
+}
+
+static int compare_quads(const void *a, const void *b) {
+    const RenderQuad *x = a;
+    const RenderQuad *y = b;
+
+    if (x->layer != y->layer) {
+        return x->layer - y->layer;
+    }
+    if (x->texture != y->texture) {
+        return (uintptr_t)x->texture < (uintptr_t)y->texture ? -1 : 1;
+    }
+    if (x->blend != y->blend) {
+        return x->blend < y->blend ? -1 : 1;
+    }
+    // Keep submission order within a batch
+    return x->order - y->order;
+}
+
+static bool same_frect(SDL_FRect a, SDL_FRect b) {
+    return a.x == b.x && a.y == b.y && a.w == b.w && a.h == b.h;
+}
+
+static bool same_quad(const RenderQuad *a, const RenderQuad *b) {
+    return same_state(a, b) && same_frect(a->dst, b->dst) && same_frect(a->uv, b->uv) && a->color.r == b->color.r &&
+           a->color.g == b->color.g && a->color.b == b->color.b && a->color.a == b->color.a;
+}
+
+// Whole pixels the quad touches, including anti-aliased edges
+static SDL_Rect quad_bounds(const RenderQuad *quad) {
+    int left = (int)floorf(quad->dst.x) - 1;
+    int top = (int)floorf(quad->dst.y) - 1;
+    int right = (int)ceilf(quad->dst.x + quad->dst.w) + 1;
+    int bottom = (int)ceilf(quad->dst.y + quad->dst.h) + 1;
+    return (SDL_Rect){left, top, right - left, bottom - top};
+}
+
+static int rect_area(const SDL_Rect *rect) {
+    return rect->w * rect->h;
+}
+
+static void add_dirty_rect(RenderQueue *queue, SDL_Rect rect) {
+    // Fold in everything it touches; a merged rect can reach others, so repeat
+    for (int i = 0; i < queue->dirty_count; i++) {
+        if (SDL_HasIntersection(&rect, &queue->dirty[i])) {
+            SDL_UnionRect(&rect, &queue->dirty[i], &rect);
+            queue->dirty[i] = queue->dirty[--queue->dirty_count];
+            i = -1;
+        }
+    }
+
+    if (queue->dirty_count < RENDER_MAX_DIRTY_RECTS) {
+        queue->dirty[queue->dirty_count++] = rect;
+        return;
+    }
+
+    // Full: grow whichever rect gets the least bigger
+    int best = 0;
+    int best_growth = INT32_MAX;
+    for (int i = 0; i < queue->dirty_count; i++) {
+        SDL_Rect merged;
+        SDL_UnionRect(&rect, &queue->dirty[i], &merged);
+        int growth = rect_area(&merged) - rect_area(&queue->dirty[i]);
+        if (growth < best_growth) {
+            best = i;
+            best_growth = growth;
+        }
+    }
+    SDL_UnionRect(&rect, &queue->dirty[best], &queue->dirty[best]);
+}
+
+// Regions covered by a quad that was added, removed or changed since last frame
+static void find_dirty_rects(RenderQueue *queue) {
+    int count = queue->count > queue->prev_count ? queue->count : queue->prev_count;
+
+    queue->dirty_count = 0;
+    for (int i = 0; i < count; i++) {
+        bool current = i < queue->count;
+        bool previous = i < queue->prev_count;
+        if (current && previous && same_quad(&queue->quads[i], &queue->prev_quads[i])) {
+            continue;
+        }
+        if (previous) {
+            add_dirty_rect(queue, quad_bounds(&queue->prev_quads[i]));
+        }
+        if (current) {
+            add_dirty_rect(queue, quad_bounds(&queue->quads[i]));
+        }
+    }
+}
+
+static void submit_batch(RenderQueue *queue, SDL_Renderer *renderer, int start, int end) {
+    const RenderQuad *first = &queue->quads[start];
+    int count = end - start;
+
+    bool one_color = first->texture == NULL;
+    for (int i = start + 1; i < end && one_color; i++) {
+        SDL_Color c = queue->quads[i].color;
+        one_color = c.r == first->color.r && c.g == first->color.g && c.b == first->color.b && c.a == first->color.a;
+    }
+
+    if (first->texture == NULL) {
+        SDL_SetRenderDrawBlendMode(renderer, first->blend);
+    } else {
+        SDL_SetTextureBlendMode(first->texture, first->blend);
+    }
+
+    if (one_color) {
+        for (int i = 0; i < count; i++) {
+            queue->rects[i] = queue->quads[start + i].dst;
+        }
+        SDL_SetRenderDrawColor(renderer, first->color.r, first->color.g, first->color.b, first->color.a);
+        SDL_RenderFillRectsF(renderer, queue->rects, count);
+    } else {
+        for (int i = 0; i < count; i++) {
+            const RenderQuad *q = &queue->quads[start + i];
+            float left = q->dst.x;
+            float top = q->dst.y;
+            float right = q->dst.x + q->dst.w;
+            float bottom = q->dst.y + q->dst.h;
+            float u0 = q->uv.x;
+            float v0 = q->uv.y;
+            float u1 = q->uv.x + q->uv.w;
+            float v1 = q->uv.y + q->uv.h;
+
+            SDL_Vertex *v = &queue->vertices[i * 4];
+            v[0] = (SDL_Vertex){{left, top}, q->color, {u0, v0}};
+            v[1] = (SDL_Vertex){{right, top}, q->color, {u1, v0}};
+            v[2] = (SDL_Vertex){{right, bottom}, q->color, {u1, v1}};
+            v[3] = (SDL_Vertex){{left, bottom}, q->color, {u0, v1}};
+
+            int *index = &queue->indices[i * 6];
+            int base = i * 4;
+            index[0] = base;
+            index[1] = base + 1;
+            index[2] = base + 2;
+            index[3] = base;
+            index[4] = base + 2;
+            index[5] = base + 3;
+        }
+        SDL_RenderGeometry(renderer, first->texture, queue->vertices, count * 4, queue->indices, count * 6);
+    }
+
+    queue->stats.draw_calls++;
+}
+
+static void submit_bulk(RenderQueue *queue, SDL_Renderer *renderer) {
+    const SDL_Color c = queue->bulk_color;
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_NONE);
+    SDL_SetRenderDrawColor(renderer, c.r, c.g, c.b, c.a);
+    SDL_RenderFillRectsF(renderer, queue->bulk_rects, queue->bulk_count);
+    queue->stats.draw_calls++;
+}
+
+static void submit_batches(RenderQueue *queue, SDL_Renderer *renderer) {
+    int start = 0;
+    int batches = 0;
+    bool bulk_pending = queue->bulk_count > 0;
+    for (int i = 1; i <= queue->count; i++) {
+        if (i == queue->count || !same_state(&queue->quads[i], &queue->quads[start])) {
+            if (bulk_pending && queue->quads[start].layer > queue->bulk_layer) {
+                submit_bulk(queue, renderer);
+                bulk_pending = false;
+                batches++;
+            }
+            submit_batch(queue, renderer, start, i);
+            start = i;
+            batches++;
+        }
+    }
+    if (bulk_pending) {
+        submit_bulk(queue, renderer);
+        batches++;
+    }
+    queue->stats.batches = batches;
+}
+
+void render_queue_flush(RenderQueue *queue, SDL_Renderer *renderer) {
+    const SDL_Color clear = queue->clear_color;
+
+    qsort(queue->quads, queue->count, sizeof(RenderQuad), compare_quads);
+    queue->stats = (RenderStats){.quads = queue->count + queue->bulk_count, .dropped = queue->dropped};
+    if (queue->dropped > 0 && !queue->hasReportedDrops) {
+        fprintf(stderr, "Render queue full: %d quads were not drawn this frame\n", queue->dropped);
+        queue->hasReportedDrops = true;
+    }
+
+    // Rect arrays aren't diffed; they change every frame anyway
+    if (!queue->useDirtyRects || queue->needsFullRedraw || queue->bulk_count > 0) {
+        SDL_SetRenderDrawColor(renderer, clear.r, clear.g, clear.b, clear.a);
+        SDL_RenderClear(renderer);
+        queue->stats.draw_calls++;
+        queue->stats.dirty_rects = 1;
+        submit_batches(queue, renderer);
+    } else {
+        find_dirty_rects(queue);
+        queue->stats.dirty_rects = queue->dirty_count;
+
+        // SDL_RenderClear ignores the clip rect, so clear each region with a fill
+        for (int i = 0; i < queue->dirty_count; i++) {
+            SDL_RenderSetClipRect(renderer, &queue->dirty[i]);
+            SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_NONE);
+            SDL_SetRenderDrawColor(renderer, clear.r, clear.g, clear.b, clear.a);
+            SDL_RenderFillRect(renderer, &queue->dirty[i]);
+            queue->stats.draw_calls++;
+            submit_batches(queue, renderer);
+        }
+        if (queue->dirty_count > 0) {
+            SDL_RenderSetClipRect(renderer, NULL);
+        }
+    }
+
+    SDL_memcpy(queue->prev_quads, queue->quads, queue->count * sizeof(RenderQuad));
+    queue->prev_count = queue->count;
+    // The next frame has to clear away this one's rect array too
+    queue->needsFullRedraw = queue->bulk_count > 0;
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+
+#include <stdbool.h>
+
+// Collects every quad of a frame, sorts them by layer, texture and blend mode
+// and submits each run as a single SDL_RenderFillRectsF or SDL_RenderGeometry
+// call, so draw calls don't grow with the number of things on screen.
+//
+// On the software renderer the previous frame is still in the window surface,
+// so only the regions that changed since then are cleared and redrawn.
+
+#define RENDER_QUEUE_CAPACITY 1024
+// More dirty regions than this get merged together
+#define RENDER_MAX_DIRTY_RECTS 8
+
+// Back to front; quads in the same layer may be drawn in any order
+typedef enum {
+    LAYER_FIELD,
+    LAYER_HUD,
+    LAYER_OVERLAY,
+    LAYER_OVERLAY_TEXT,
+} RenderLayer;
+
+typedef struct {
+    SDL_FRect dst;
+    // Texture coordinates in 0..1, unused for solid quads
+    SDL_FRect uv;
+    SDL_Color color;
+    SDL_Texture *texture;
+    SDL_BlendMode blend;
+    int layer;
+    int order;
+} RenderQuad;
+
+typedef struct {
+    int quads;
+    int batches;
+    int draw_calls;
+    int dirty_rects;
+    // Quads pushed after the queue was full, which were not drawn
+    int dropped;
+} RenderStats;
+
+typedef struct {
+    RenderQuad quads[RENDER_QUEUE_CAPACITY];
+    int count;
+    int dropped;
+    // Running out of room is reported once, not every frame
+    bool hasReportedDrops;
+    SDL_Color clear_color;
+
+    // Last frame's quads, sorted, to find what changed
+    RenderQuad prev_quads[RENDER_QUEUE_CAPACITY];
+    int prev_count;
+    SDL_Rect dirty[RENDER_MAX_DIRTY_RECTS];
+    int dirty_count;
+
+    bool useDirtyRects;
+    bool needsFullRedraw;
+    RenderStats stats;
+
+    // Caller's rects for push_rect_array, drawn after the quads of bulk_layer
+    const SDL_FRect *bulk_rects;
+    int bulk_count;
+    int bulk_layer;
+    SDL_Color bulk_color;
+
+    SDL_Vertex vertices[RENDER_QUEUE_CAPACITY * 4];
+    int indices[RENDER_QUEUE_CAPACITY * 6];
+    SDL_FRect rects[RENDER_QUEUE_CAPACITY];
+} RenderQueue;
+
+void render_queue_init(RenderQueue *queue, SDL_Renderer *renderer);
+void render_queue_begin(RenderQueue *queue, SDL_Color clear_color);
+// The next flush redraws the whole target, e.g. after the window was exposed
+void render_queue_invalidate(RenderQueue *queue);
+
+void push_rect(RenderQueue *queue, RenderLayer layer, SDL_FRect dst, SDL_Color color, SDL_BlendMode blend);
+void push_textured_quad(RenderQueue *queue, RenderLayer layer, SDL_Texture *texture, SDL_FRect dst, SDL_FRect uv,
+                        SDL_Color color);
+// Any number of solid rects in one SDL_RenderFillRectsF call, for more than the
+// queue holds. rects must stay valid until the flush, which then redraws the
+// whole target. One array per frame.
+void push_rect_array(RenderQueue *queue, RenderLayer layer, const SDL_FRect *rects, int count, SDL_Color color);
+
+void render_queue_flush(RenderQueue *queue, SDL_Renderer *renderer);
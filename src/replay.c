@@ -0,0 +1,487 @@
+#include "replay.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static void put_u32(uint8_t *out, uint32_t value) {
+    for (int i = 0; i < 4; i++) {
+        out[i] = (uint8_t)(value >> (8 * i));
+    }
+}
+
+static void put_u64(uint8_t *out, uint64_t value) {
+    for (int i = 0; i < 8; i++) {
+        out[i] = (uint8_t)(value >> (8 * i));
+    }
+}
+
+static void put_f32(uint8_t *out, float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    put_u32(out, bits);
+}
+
+static uint32_t get_u32(const uint8_t *in) {
+    uint32_t value = 0;
+    for (int i = 0; i < 4; i++) {
+        value |= (uint32_t)in[i] << (8 * i);
+    }
+    return value;
+}
+
+static uint64_t get_u64(const uint8_t *in) {
+    uint64_t value = 0;
+    for (int i = 0; i < 8; i++) {
+        value |= (uint64_t)in[i] << (8 * i);
+    }
+    return value;
+}
+
+static float get_f32(const uint8_t *in) {
+    uint32_t bits = get_u32(in);
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+static void pack_paddle(uint8_t *out, const Paddle *p) {
+    put_f32(out, p->pos.x);
+    put_f32(out + 4, p->pos.y);
+    put_f32(out + 8, p->width);
+    put_f32(out + 12, p->height);
+    put_f32(out + 16, p->speed);
+    put_u32(out + 20, (uint32_t)p->score);
+}
+
+static void unpack_paddle(const uint8_t *in, Paddle *p) {
+    p->pos.x = get_f32(in);
+    p->pos.y = get_f32(in + 4);
+    p->width = get_f32(in + 8);
+    p->height = get_f32(in + 12);
+    p->speed = get_f32(in + 16);
+    p->score = (int)get_u32(in + 20);
+}
+
+// Every field of the Match, so restoring a snapshot is bit-exact
+static void pack_snapshot(uint8_t *out, const Match *match, float total_time) {
+    memset(out, 0, REPLAY_SNAPSHOT_SIZE);
+    put_f32(out, match->ball.pos.x);
+    put_f32(out + 4, match->ball.pos.y);
+    put_f32(out + 8, match->ball.dir.x);
+    put_f32(out + 12, match->ball.dir.y);
+    put_f32(out + 16, match->ball.speed);
+    put_f32(out + 20, match->ball.radius);
+    pack_paddle(out + 24, &match->p1);
+    pack_paddle(out + 48, &match->p2);
+    put_u64(out + 72, match->rng);
+    put_f32(out + 80, total_time);
+    out[84] = match->hasStarted;
+}
+
+static void unpack_snapshot(const uint8_t *in, Match *match, float *total_time) {
+    *match = (Match){0};
+    match->ball.pos.x = get_f32(in);
+    match->ball.pos.y = get_f32(in + 4);
+    match->ball.dir.x = get_f32(in + 8);
+    match->ball.dir.y = get_f32(in + 12);
+    match->ball.speed = get_f32(in + 16);
+    match->ball.radius = get_f32(in + 20);
+    unpack_paddle(in + 24, &match->p1);
+    unpack_paddle(in + 48, &match->p2);
+    match->rng = get_u64(in + 72);
+    *total_time = get_f32(in + 80);
+    match->hasStarted = in[84] != 0;
+}
+
+uint8_t encode_input(MatchInput input) {
+    return (uint8_t)((input.p1 + 1) | (input.p2 + 1) << 2 | (input.serve ? INPUT_SERVE_BIT : 0));
+}
+
+MatchInput decode_input(uint8_t input) {
+    return (MatchInput){
+        .p1 = (int8_t)(input & 3) - 1,
+        .p2 = (int8_t)(input >> 2 & 3) - 1,
+        .serve = (input & INPUT_SERVE_BIT) != 0,
+    };
+}
+
+bool replay_writer_open(ReplayWriter *writer, const char *path, uint64_t seed, float dt) {
+    *writer = (ReplayWriter){0};
+
+    writer->file = fopen(path, "wb");
+    if (writer->file == NULL) {
+        fprintf(stderr, "Unable to open %s for recording\n", path);
+        return false;
+    }
+
+    // The counts and offsets stay zero until close, which marks a file that was never finished
+    uint8_t header[REPLAY_HEADER_SIZE] = {0};
+    memcpy(header, REPLAY_MAGIC, 8);
+    put_u32(header + 8, REPLAY_VERSION);
+    put_u64(header + 16, seed);
+    put_f32(header + 24, dt);
+    put_u32(header + 28, REPLAY_KEYFRAME_INTERVAL);
+    if (fwrite(header, sizeof(header), 1, writer->file) != 1 || fflush(writer->file) != 0) {
+        fprintf(stderr, "Unable to write to %s\n", path);
+        fclose(writer->file);
+        writer->file = NULL;
+        return false;
+    }
+    return true;
+}
+
+static bool add_keyframe(ReplayWriter *writer, const Match *match, float total_time, uint32_t flags) {
+    if (writer->keyframe_count == writer->keyframe_capacity) {
+        uint32_t capacity = writer->keyframe_capacity ? 2 * writer->keyframe_capacity : 64;
+        uint8_t *keyframes = realloc(writer->keyframes, (size_t)capacity * REPLAY_KEYFRAME_SIZE);
+        if (keyframes == NULL) {
+            return false;
+        }
+        writer->keyframes = keyframes;
+        writer->keyframe_capacity = capacity;
+    }
+
+    uint8_t *out = writer->keyframes + (size_t)writer->keyframe_count * REPLAY_KEYFRAME_SIZE;
+    memset(out, 0, 24);
+    put_u32(out, writer->tick);
+    put_u32(out + 4, flags);
+    put_u32(out + 8, writer->last_change);
+    out[12] = writer->input;
+    put_u64(out + 16, writer->offset);
+    pack_snapshot(out + 24, match, total_time);
+
+    writer->keyframe_count++;
+    return true;
+}
+
+static bool write_varint(ReplayWriter *writer, uint32_t value) {
+    do {
+        uint8_t byte = value & 0x7F;
+        value >>= 7;
+        if (value != 0) {
+            byte |= 0x80;
+        }
+        if (fputc(byte, writer->file) == EOF) {
+            return false;
+        }
+        writer->offset++;
+    } while (value != 0);
+    return true;
+}
+
+bool replay_writer_tick(ReplayWriter *writer, const Match *match, float total_time, MatchInput input) {
+    if (writer->file == NULL) {
+        return false;
+    }
+
+    bool due = writer->keyframe_count == 0 ||
+               writer->tick - get_u32(writer->keyframes + (size_t)(writer->keyframe_count - 1) * REPLAY_KEYFRAME_SIZE) >=
+                   REPLAY_KEYFRAME_INTERVAL;
+    if (due || writer->reset_pending) {
+        if (!add_keyframe(writer, match, total_time, writer->reset_pending ? KEYFRAME_RESET : 0)) {
+            fprintf(stderr, "Out of memory for replay keyframes\n");
+            return false;
+        }
+        writer->reset_pending = false;
+    }
+
+    // Only changes are stored: ticks since the previous change, then the input
+    uint8_t encoded = encode_input(input);
+    if (writer->tick == 0 || encoded != writer->input) {
+        if (!write_varint(writer, writer->tick - writer->last_change) || fputc(encoded, writer->file) == EOF) {
+            fprintf(stderr, "Unable to write the replay inputs\n");
+            return false;
+        }
+        writer->offset++;
+        writer->last_change = writer->tick;
+        writer->input = encoded;
+    }
+
+    writer->tick++;
+    return true;
+}
+
+void replay_writer_mark_reset(ReplayWriter *writer) {
+    writer->reset_pending = true;
+}
+
+bool replay_writer_close(ReplayWriter *writer) {
+    if (writer->file == NULL) {
+        return false;
+    }
+
+    // Everything before the counts was written on open
+    uint8_t sizes[REPLAY_HEADER_SIZE - 32];
+    put_u32(sizes, writer->tick);
+    put_u32(sizes + 4, writer->keyframe_count);
+    put_u64(sizes + 8, REPLAY_HEADER_SIZE);
+    put_u64(sizes + 16, writer->offset);
+    put_u64(sizes + 24, REPLAY_HEADER_SIZE + writer->offset);
+
+    size_t table_size = (size_t)writer->keyframe_count * REPLAY_KEYFRAME_SIZE;
+    bool ok = (table_size == 0 || fwrite(writer->keyframes, table_size, 1, writer->file) == 1) &&
+              fseek(writer->file, 32, SEEK_SET) == 0 && fwrite(sizes, sizeof(sizes), 1, writer->file) == 1;
+    ok = fclose(writer->file) == 0 && ok;
+    if (!ok) {
+        fprintf(stderr, "Unable to finish writing the replay\n");
+    }
+
+    free(writer->keyframes);
+    *writer = (ReplayWriter){0};
+    return ok;
+}
+
+static bool map_file(Replay *replay, const char *path) {
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    LARGE_INTEGER size;
+    HANDLE mapping = NULL;
+    if (GetFileSizeEx(file, &size) && size.QuadPart >= REPLAY_HEADER_SIZE) {
+        mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    }
+    CloseHandle(file);
+    if (mapping == NULL) {
+        return false;
+    }
+
+    replay->data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (replay->data == NULL) {
+        CloseHandle(mapping);
+        return false;
+    }
+    replay->size = (size_t)size.QuadPart;
+    replay->mapping = mapping;
+    return true;
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat st;
+    void *data = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && st.st_size >= REPLAY_HEADER_SIZE) {
+        data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    close(fd);
+    if (data == MAP_FAILED) {
+        return false;
+    }
+
+    replay->data = data;
+    replay->size = (size_t)st.st_size;
+    return true;
+#endif
+}
+
+void replay_close(Replay *replay) {
+    if (replay->data != NULL) {
+#ifdef _WIN32
+        UnmapViewOfFile(replay->data);
+        CloseHandle(replay->mapping);
+#else
+        munmap((void *)replay->data, replay->size);
+#endif
+    }
+    *replay = (Replay){0};
+}
+
+static bool read_varint(const Replay *replay, uint64_t *offset, uint32_t *value);
+
+static void recover_inputs(Replay *replay) {
+    replay->isUnfinished = true;
+    replay->inputs = replay->data + REPLAY_HEADER_SIZE;
+    replay->inputs_size = replay->size - REPLAY_HEADER_SIZE;
+
+    uint64_t offset = 0;
+    uint64_t complete = 0;
+    uint32_t delta;
+    uint32_t last_change = 0;
+    while (read_varint(replay, &offset, &delta) && offset < replay->inputs_size) {
+        last_change += delta;
+        replay->tick_count = last_change + 1;
+        complete = ++offset;
+    }
+    replay->inputs_size = complete;
+}
+
+bool replay_open(Replay *replay, const char *path) {
+    *replay = (Replay){0};
+
+    // Mapping rather than reading keeps opening O(1) in the file size
+    if (!map_file(replay, path)) {
+        fprintf(stderr, "Unable to map %s\n", path);
+        return false;
+    }
+
+    const uint8_t *header = replay->data;
+    if (memcmp(header, REPLAY_MAGIC, 8) != 0 || get_u32(header + 8) != REPLAY_VERSION) {
+        fprintf(stderr, "%s is not a version %d replay\n", path, REPLAY_VERSION);
+        replay_close(replay);
+        return false;
+    }
+
+    replay->seed = get_u64(header + 16);
+    replay->dt = get_f32(header + 24);
+
+    // Never closed: the keyframes were lost, but every whole input record up to the end can still be read
+    if (get_u64(header + 56) == 0) {
+        recover_inputs(replay);
+        return true;
+    }
+
+    replay->tick_count = get_u32(header + 32);
+    replay->keyframe_count = get_u32(header + 36);
+    uint64_t inputs_offset = get_u64(header + 40);
+    replay->inputs_size = get_u64(header + 48);
+    uint64_t keyframes_offset = get_u64(header + 56);
+
+    uint64_t table_size = (uint64_t)replay->keyframe_count * REPLAY_KEYFRAME_SIZE;
+    if (inputs_offset > replay->size || replay->inputs_size > replay->size - inputs_offset ||
+        keyframes_offset > replay->size || table_size > replay->size - keyframes_offset ||
+        (replay->tick_count > 0 && replay->keyframe_count == 0)) {
+        fprintf(stderr, "%s is truncated or corrupt\n", path);
+        replay_close(replay);
+        return false;
+    }
+
+    replay->inputs = replay->data + inputs_offset;
+    replay->keyframes = replay->data + keyframes_offset;
+    return true;
+}
+
+void replay_keyframe(const Replay *replay, uint32_t index, Keyframe *keyframe) {
+    const uint8_t *in = replay->keyframes + (size_t)index * REPLAY_KEYFRAME_SIZE;
+
+    keyframe->tick = get_u32(in);
+    keyframe->flags = get_u32(in + 4);
+    keyframe->last_change = get_u32(in + 8);
+    keyframe->input = in[12];
+    keyframe->offset = get_u64(in + 16);
+    unpack_snapshot(in + 24, &keyframe->match, &keyframe->total_time);
+}
+
+static uint32_t keyframe_tick(const Replay *replay, uint32_t index) {
+    return get_u32(replay->keyframes + (size_t)index * REPLAY_KEYFRAME_SIZE);
+}
+
+static void load_keyframe(ReplayCursor *cursor, uint32_t index) {
+    Keyframe keyframe;
+    replay_keyframe(cursor->replay, index, &keyframe);
+
+    cursor->tick = keyframe.tick;
+    cursor->last_change = keyframe.last_change;
+    cursor->input = keyframe.input;
+    cursor->offset = keyframe.offset;
+    cursor->next_keyframe = index + 1;
+    cursor->match = keyframe.match;
+    cursor->total_time = keyframe.total_time;
+}
+
+bool replay_seek(const Replay *replay, ReplayCursor *cursor, uint32_t tick) {
+    if (tick > replay->tick_count || replay->keyframe_count == 0) {
+        return false;
+    }
+
+    // Last keyframe at or before the target
+    uint32_t lo = 0;
+    uint32_t hi = replay->keyframe_count;
+    while (hi - lo > 1) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (keyframe_tick(replay, mid) <= tick) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+
+    cursor->replay = replay;
+    load_keyframe(cursor, lo);
+
+    // At most REPLAY_KEYFRAME_INTERVAL ticks
+    while (cursor->tick < tick) {
+        replay_step(cursor, NULL);
+    }
+    return true;
+}
+
+static bool read_varint(const Replay *replay, uint64_t *offset, uint32_t *value) {
+    *value = 0;
+    for (int shift = 0; shift < 32; shift += 7) {
+        if (*offset >= replay->inputs_size) {
+            return false;
+        }
+        uint8_t byte = replay->inputs[(*offset)++];
+        *value |= (uint32_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+MatchEvent replay_step(ReplayCursor *cursor, MatchInput *input) {
+    const Replay *replay = cursor->replay;
+
+    // State that changed outside of step_match is loaded, not simulated
+    while (cursor->next_keyframe < replay->keyframe_count && keyframe_tick(replay, cursor->next_keyframe) <= cursor->tick) {
+        const uint8_t *keyframe = replay->keyframes + (size_t)cursor->next_keyframe * REPLAY_KEYFRAME_SIZE;
+        if (get_u32(keyframe) == cursor->tick && (get_u32(keyframe + 4) & KEYFRAME_RESET)) {
+            unpack_snapshot(keyframe + 24, &cursor->match, &cursor->total_time);
+        }
+        cursor->next_keyframe++;
+    }
+
+    uint64_t offset = cursor->offset;
+    uint32_t delta;
+    if (read_varint(replay, &offset, &delta) && cursor->last_change + delta == cursor->tick &&
+        offset < replay->inputs_size) {
+        cursor->input = replay->inputs[offset];
+        cursor->offset = offset + 1;
+        cursor->last_change = cursor->tick;
+    }
+
+    MatchInput tick_input = decode_input(cursor->input);
+    if (input != NULL) {
+        *input = tick_input;
+    }
+
+    MatchEvent event = step_match(&cursor->match, tick_input, replay->dt, cursor->total_time);
+    cursor->total_time += replay->dt;
+    cursor->tick++;
+    return event;
+}
+
+int64_t replay_verify(const Replay *replay) {
+    ReplayCursor cursor;
+    if (!replay_seek(replay, &cursor, 0)) {
+        return replay->tick_count > 0 ? 0 : -1;
+    }
+
+    uint8_t snapshot[REPLAY_SNAPSHOT_SIZE];
+    while (cursor.tick < replay->tick_count) {
+        // Every periodic keyframe must match what the inputs reproduce
+        if (cursor.next_keyframe < replay->keyframe_count && keyframe_tick(replay, cursor.next_keyframe) == cursor.tick) {
+            const uint8_t *keyframe = replay->keyframes + (size_t)cursor.next_keyframe * REPLAY_KEYFRAME_SIZE;
+            pack_snapshot(snapshot, &cursor.match, cursor.total_time);
+            if (!(get_u32(keyframe + 4) & KEYFRAME_RESET) && memcmp(snapshot, keyframe + 24, REPLAY_SNAPSHOT_SIZE) != 0) {
+                return cursor.tick;
+            }
+        }
+        replay_step(&cursor, NULL);
+    }
+    return -1;
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include "sim.h"
+
+#include <stddef.h>
+#include <stdio.h>
+
+// Replay files: the per-tick MatchInput stream, delta encoded as
+// (ticks since last change, new input) records, plus a keyframe table of full
+// Match snapshots. Seeking restores the nearest keyframe at or before the
+// target and resimulates at most REPLAY_KEYFRAME_INTERVAL ticks.
+//
+// Layout: header | input records | keyframe table. All little-endian.
+
+#define REPLAY_MAGIC "PONGRPL1"
+#define REPLAY_VERSION 1
+#define REPLAY_KEYFRAME_INTERVAL 600
+
+#define REPLAY_HEADER_SIZE 64
+#define REPLAY_SNAPSHOT_SIZE 88
+#define REPLAY_KEYFRAME_SIZE (24 + REPLAY_SNAPSHOT_SIZE)
+
+// The state was changed outside of step_match (a new match, a re-serve), so
+// playback has to load this keyframe rather than simulate up to it.
+#define KEYFRAME_RESET 1u
+
+typedef struct {
+    uint32_t tick;
+    uint32_t flags;
+    uint32_t last_change;
+    uint8_t input;
+    uint64_t offset;
+    Match match;
+    float total_time;
+} Keyframe;
+
+typedef struct {
+    FILE *file;
+
+    uint32_t tick;
+    uint32_t last_change;
+    uint8_t input;
+    uint64_t offset;
+    bool reset_pending;
+
+    // Packed keyframe table, written after the inputs on close
+    uint8_t *keyframes;
+    uint32_t keyframe_count;
+    uint32_t keyframe_capacity;
+} ReplayWriter;
+
+typedef struct {
+    const uint8_t *data;
+    size_t size;
+    void *mapping;
+
+    uint64_t seed;
+    float dt;
+    uint32_t tick_count;
+    uint32_t keyframe_count;
+    const uint8_t *inputs;
+    uint64_t inputs_size;
+    const uint8_t *keyframes;
+    // The writer never closed it: the inputs are recovered up to the last whole
+    // record, but there are no keyframes to play them from
+    bool isUnfinished;
+} Replay;
+
+typedef struct {
+    const Replay *replay;
+    uint32_t tick;
+    uint32_t last_change;
+    uint8_t input;
+    uint64_t offset;
+    uint32_t next_keyframe;
+    Match match;
+    float total_time;
+} ReplayCursor;
+
+bool replay_writer_open(ReplayWriter *writer, const char *path, uint64_t seed, float dt);
+// Call before every tick with the state the tick starts from and its input
+bool replay_writer_tick(ReplayWriter *writer, const Match *match, float total_time, MatchInput input);
+void replay_writer_mark_reset(ReplayWriter *writer);
+bool replay_writer_close(ReplayWriter *writer);
+
+// Also opens a file whose writer never closed, with isUnfinished set
+bool replay_open(Replay *replay, const char *path);
+void replay_close(Replay *replay);
+void replay_keyframe(const Replay *replay, uint32_t index, Keyframe *keyframe);
+
+bool replay_seek(const Replay *replay, ReplayCursor *cursor, uint32_t tick);
+// Plays the cursor's tick and moves to the next one
+MatchEvent replay_step(ReplayCursor *cursor, MatchInput *input);
+
+// Plays the whole replay from the start and checks every keyframe against the
+// resimulated state. Returns the first tick that desyncs, or -1.
+int64_t replay_verify(const Replay *replay);
+
+// Low bits of an encoded input: p1 + 1, p2 + 1 << 2, then the serve flag
+#define INPUT_SERVE_BIT (1 << 4)
+
+uint8_t encode_input(MatchInput input);
+MatchInput decode_input(uint8_t input);
@@ -0,0 +1,163 @@
+#include "replay.h"
+#include "timer.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void print_usage(const char *program) {
+    fprintf(stderr,
+            "Usage: %s info FILE\n"
+            "       %s verify FILE\n"
+            "       %s dump FILE [--from TICK] [--to TICK]\n"
+            "       %s seek FILE TICK\n",
+            program, program, program, program);
+}
+
+static void print_state_header() {
+    printf("tick,time,p1_input,p2_input,serve,ball_x,ball_y,dir_x,dir_y,p1_y,p2_y,p1_score,p2_score,started,rng,event\n");
+}
+
+// %.9g round-trips a float, so dumps from two builds can be diffed exactly
+static void print_state(uint32_t tick, const ReplayCursor *cursor, MatchInput input, MatchEvent event) {
+    const Match *m = &cursor->match;
+    printf("%u,%.9g,%d,%d,%d,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g,%d,%d,%d,%016llx,%d\n", tick, cursor->total_time, input.p1,
+           input.p2, input.serve, m->ball.pos.x, m->ball.pos.y, m->ball.dir.x, m->ball.dir.y, m->p1.pos.y, m->p2.pos.y,
+           m->p1.score, m->p2.score, m->hasStarted, (unsigned long long)m->rng, event);
+}
+
+static int run_info(const Replay *replay) {
+    uint32_t resets = 0;
+    for (uint32_t i = 0; i < replay->keyframe_count; i++) {
+        Keyframe keyframe;
+        replay_keyframe(replay, i, &keyframe);
+        resets += (keyframe.flags & KEYFRAME_RESET) != 0;
+    }
+
+    printf("seed %llu, dt %.9g\n", (unsigned long long)replay->seed, replay->dt);
+    printf("%u ticks (%.1f s), %llu input bytes, %u keyframes (%u resets)\n", replay->tick_count,
+           replay->tick_count * (double)replay->dt, (unsigned long long)replay->inputs_size, replay->keyframe_count,
+           resets);
+    printf("%zu bytes total, %.3f bytes/tick\n", replay->size,
+           replay->tick_count > 0 ? (double)replay->size / replay->tick_count : 0.0);
+    if (replay->isUnfinished) {
+        printf("unfinished: inputs recovered up to the last change, without keyframes\n");
+    }
+    return 0;
+}
+
+static int run_verify(const Replay *replay) {
+    double start = timer_seconds();
+    int64_t desync = replay_verify(replay);
+    double elapsed = timer_seconds() - start;
+    if (elapsed <= 0) {
+        elapsed = 1e-9;
+    }
+
+    if (desync >= 0) {
+        fprintf(stderr, "desync at tick %lld: the simulation no longer reproduces this replay\n", (long long)desync);
+        return 1;
+    }
+    printf("verified %u ticks and %u keyframes in %.3f s (%.0f ticks/sec, %.0fx real time)\n", replay->tick_count,
+           replay->keyframe_count, elapsed, replay->tick_count / elapsed,
+           replay->tick_count * (double)replay->dt / elapsed);
+    return 0;
+}
+
+static int run_dump(const Replay *replay, uint32_t from, uint32_t to) {
+    if (to > replay->tick_count) {
+        to = replay->tick_count;
+    }
+
+    ReplayCursor cursor;
+    if (from >= to || !replay_seek(replay, &cursor, from)) {
+        fprintf(stderr, "Nothing to dump between ticks %u and %u\n", from, to);
+        return -1;
+    }
+
+    // Each row is the state after the tick has been played
+    print_state_header();
+    while (cursor.tick < to) {
+        uint32_t tick = cursor.tick;
+        MatchInput input;
+        MatchEvent event = replay_step(&cursor, &input);
+        print_state(tick, &cursor, input, event);
+    }
+    return 0;
+}
+
+static int run_seek(const Replay *replay, uint32_t tick) {
+    ReplayCursor cursor;
+    double start = timer_seconds();
+    if (!replay_seek(replay, &cursor, tick)) {
+        fprintf(stderr, "Tick %u is past the end of the replay (%u ticks)\n", tick, replay->tick_count);
+        return -1;
+    }
+    double elapsed = timer_seconds() - start;
+
+    // State at the start of the tick, before its input is applied
+    print_state_header();
+    print_state(tick, &cursor, (MatchInput){0}, MATCH_EVENT_NONE);
+    fprintf(stderr, "seek took %.1f us\n", elapsed * 1e6);
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        print_usage(argv[0]);
+        return -1;
+    }
+
+    const char *command = argv[1];
+    uint32_t from = 0;
+    uint32_t to = UINT32_MAX;
+    uint32_t tick = 0;
+
+    if (strcmp(command, "seek") == 0) {
+        if (argc != 4) {
+            print_usage(argv[0]);
+            return -1;
+        }
+        tick = strtoul(argv[3], NULL, 10);
+    } else if (strcmp(command, "dump") == 0) {
+        for (int i = 3; i < argc; i++) {
+            const char *arg = argv[i];
+            bool has_value = i + 1 < argc;
+
+            if (strcmp(arg, "--from") == 0 && has_value) {
+                from = strtoul(argv[++i], NULL, 10);
+            } else if (strcmp(arg, "--to") == 0 && has_value) {
+                to = strtoul(argv[++i], NULL, 10);
+            } else {
+                print_usage(argv[0]);
+                return -1;
+            }
+        }
+    } else if ((strcmp(command, "info") != 0 && strcmp(command, "verify") != 0) || argc != 3) {
+        print_usage(argv[0]);
+        return -1;
+    }
+
+    Replay replay;
+    if (!replay_open(&replay, argv[2])) {
+        return -1;
+    }
+
+    int result;
+    if (replay.isUnfinished && strcmp(command, "info") != 0) {
+        fprintf(stderr, "%s was never finished, so it has no keyframes to play from; only info can read it\n",
+                argv[2]);
+        result = -1;
+    } else if (strcmp(command, "info") == 0) {
+        result = run_info(&replay);
+    } else if (strcmp(command, "verify") == 0) {
+        result = run_verify(&replay);
+    } else if (strcmp(command, "dump") == 0) {
+        result = run_dump(&replay, from, to);
+    } else {
+        result = run_seek(&replay, tick);
+    }
+
+    replay_close(&replay);
+    return result;
+}
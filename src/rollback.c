@@ -0,0 +1,175 @@
+#include "rollback.h"
+
+#include "replay.h"
+
+static void put_u32(uint8_t *out, uint32_t value) {
+    for (int i = 0; i < 4; i++) {
+        out[i] = (uint8_t)(value >> (8 * i));
+    }
+}
+
+static uint32_t get_u32(const uint8_t *in) {
+    uint32_t value = 0;
+    for (int i = 0; i < 4; i++) {
+        value |= (uint32_t)in[i] << (8 * i);
+    }
+    return value;
+}
+
+void rollback_init(RollbackSession *session, uint64_t seed, int local, int input_delay, float dt) {
+    *session = (RollbackSession){
+        .local = local,
+        .input_delay = input_delay,
+        .dt = dt,
+        .rollback_from = UINT32_MAX,
+    };
+    match_init(&session->match, seed);
+    session->states[0] = session->match;
+
+    // Nobody has pressed anything during the first input_delay frames
+    uint8_t neutral = encode_input((MatchInput){0});
+    for (int f = 0; f < input_delay; f++) {
+        session->inputs[local][f] = neutral;
+    }
+    session->local_frames = (uint32_t)input_delay;
+}
+
+static uint8_t remote_input(const RollbackSession *session, uint32_t frame) {
+    int remote = 1 - session->local;
+    if (frame < session->remote_frames) {
+        return session->inputs[remote][frame % ROLLBACK_INPUT_HISTORY];
+    }
+
+    // Predict the last known direction held; a serve is a one-off
+    if (session->remote_frames == 0) {
+        return encode_input((MatchInput){0});
+    }
+    uint8_t last = session->inputs[remote][(session->remote_frames - 1) % ROLLBACK_INPUT_HISTORY];
+    return last & ~INPUT_SERVE_BIT;
+}
+
+static void simulate_frame(RollbackSession *session) {
+    uint32_t f = session->frame;
+    session->states[f % ROLLBACK_WINDOW] = session->match;
+    session->times[f % ROLLBACK_WINDOW] = session->total_time;
+
+    uint8_t remote = remote_input(session, f);
+    session->used[f % ROLLBACK_WINDOW] = remote;
+
+    MatchInput own = decode_input(session->inputs[session->local][f % ROLLBACK_INPUT_HISTORY]);
+    MatchInput other = decode_input(remote);
+    MatchInput p1 = session->local == 0 ? own : other;
+    MatchInput p2 = session->local == 0 ? other : own;
+    MatchInput input = {.p1 = p1.p1, .p2 = p2.p2, .serve = p1.serve || p2.serve};
+
+    step_match(&session->match, input, session->dt, session->total_time);
+    session->total_time += session->dt;
+    session->frame++;
+}
+
+bool rollback_can_advance(const RollbackSession *session) {
+    // Every unconfirmed frame needs a saved state to roll back to
+    uint32_t unconfirmed = session->frame > session->remote_frames ? session->frame - session->remote_frames : 0;
+    return unconfirmed < ROLLBACK_WINDOW - 1 && session->local_frames - session->remote_ack < ROLLBACK_INPUT_HISTORY - 1;
+}
+
+int rollback_advance(RollbackSession *session, MatchInput local_input) {
+    if (!rollback_can_advance(session)) {
+        session->stats.stalls++;
+        return -1;
+    }
+
+    session->inputs[session->local][session->local_frames % ROLLBACK_INPUT_HISTORY] = encode_input(local_input);
+    session->local_frames++;
+
+    int resimulated = 0;
+    if (session->rollback_from < session->frame) {
+        uint32_t now = session->frame;
+        uint32_t from = session->rollback_from;
+        session->match = session->states[from % ROLLBACK_WINDOW];
+        session->total_time = session->times[from % ROLLBACK_WINDOW];
+        session->frame = from;
+        while (session->frame < now) {
+            simulate_frame(session);
+        }
+
+        resimulated = (int)(now - from);
+        session->stats.rollbacks++;
+        session->stats.resimulated += resimulated;
+        if (resimulated > session->stats.max_rollback) {
+            session->stats.max_rollback = resimulated;
+        }
+    }
+    session->rollback_from = UINT32_MAX;
+
+    if (session->frame >= session->remote_frames) {
+        session->stats.predicted++;
+    }
+    simulate_frame(session);
+    session->stats.frames++;
+    return resimulated;
+}
+
+size_t rollback_write_packet(const RollbackSession *session, uint8_t *packet) {
+    uint32_t start = session->remote_ack;
+    uint32_t count = session->local_frames - start;
+    if (count > ROLLBACK_MAX_PACKET_INPUTS) {
+        // Still short of what the peer lacks; it will ack these and ask on
+        count = ROLLBACK_MAX_PACKET_INPUTS;
+    }
+
+    packet[0] = ROLLBACK_PACKET_MAGIC & 0xff;
+    packet[1] = ROLLBACK_PACKET_MAGIC >> 8;
+    put_u32(packet + 2, session->remote_frames);
+    put_u32(packet + 6, start);
+    packet[10] = (uint8_t)count;
+    for (uint32_t i = 0; i < count; i++) {
+        packet[ROLLBACK_PACKET_HEADER + i] = session->inputs[session->local][(start + i) % ROLLBACK_INPUT_HISTORY];
+    }
+    return ROLLBACK_PACKET_HEADER + count;
+}
+
+bool rollback_read_packet(RollbackSession *session, const uint8_t *packet, size_t size) {
+    if (size < ROLLBACK_PACKET_HEADER || (packet[0] | packet[1] << 8) != ROLLBACK_PACKET_MAGIC ||
+        size != ROLLBACK_PACKET_HEADER + (size_t)packet[10]) {
+        return false;
+    }
+
+    uint32_t ack = get_u32(packet + 2);
+    uint32_t start = get_u32(packet + 6);
+    uint32_t end = start + packet[10];
+    if (ack > session->local_frames) {
+        return false;
+    }
+    if (ack > session->remote_ack) {
+        session->remote_ack = ack;
+    }
+
+    // Inputs are only taken contiguously; a gap left by a lost packet is
+    // filled by the next one, which starts from the same ack
+    if (start > session->remote_frames || end <= session->remote_frames) {
+        return true;
+    }
+
+    int remote = 1 - session->local;
+    for (uint32_t f = session->remote_frames; f < end; f++) {
+        uint8_t input = packet[ROLLBACK_PACKET_HEADER + (f - start)];
+        session->inputs[remote][f % ROLLBACK_INPUT_HISTORY] = input;
+
+        if (f < session->frame && input != session->used[f % ROLLBACK_WINDOW]) {
+            session->stats.mispredicted++;
+            if (f < session->rollback_from) {
+                session->rollback_from = f;
+            }
+        }
+    }
+    session->remote_frames = end;
+    return true;
+}
+
+const Match *rollback_previous_match(const RollbackSession *session) {
+    if (session->frame == 0) {
+        return &session->match;
+    }
+    return &session->states[(session->frame - 1) % ROLLBACK_WINDOW];
+}
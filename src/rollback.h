@@ -0,0 +1,82 @@
+#pragma once
+
+#include "sim.h"
+
+#include <stddef.h>
+
+// Rollback netcode for two players, independent of the transport. Each side
+// simulates every frame as soon as it has its own input, predicting the
+// remote one (same direction as last time, no serve). When the real remote
+// input for an already simulated frame turns out different, the match is
+// restored to that frame and resimulated up to the present.
+//
+// Local inputs are applied input_delay frames after they are given, which
+// hides that much network latency without any rollback.
+
+// Frames of saved states; also how far ahead of the remote inputs we may run
+#define ROLLBACK_WINDOW 64
+// Inputs kept per player, enough to resend everything the peer may lack
+#define ROLLBACK_INPUT_HISTORY 256
+#define DEFAULT_INPUT_DELAY 2
+
+#define ROLLBACK_PACKET_MAGIC 0x5052 // "PR"
+#define ROLLBACK_PACKET_HEADER 11
+#define ROLLBACK_MAX_PACKET_INPUTS 255
+#define ROLLBACK_MAX_PACKET (ROLLBACK_PACKET_HEADER + ROLLBACK_MAX_PACKET_INPUTS)
+
+typedef struct {
+    long long frames;
+    long long predicted;
+    long long mispredicted;
+    long long rollbacks;
+    long long resimulated;
+    int max_rollback;
+    long long stalls;
+} RollbackStats;
+
+typedef struct {
+    // 0 plays as player 1, 1 as player 2
+    int local;
+    int input_delay;
+    float dt;
+
+    // The match at the start of `frame`, the next frame to simulate
+    Match match;
+    float total_time;
+    uint32_t frame;
+
+    // State at the start of frame f, at index f % ROLLBACK_WINDOW
+    Match states[ROLLBACK_WINDOW];
+    float times[ROLLBACK_WINDOW];
+
+    // encode_input() bytes per player, at index f % ROLLBACK_INPUT_HISTORY
+    uint8_t inputs[2][ROLLBACK_INPUT_HISTORY];
+    // Remote input each simulated frame actually used
+    uint8_t used[ROLLBACK_WINDOW];
+    // Frames [0, local_frames) have local input, [0, remote_frames) confirmed remote input
+    uint32_t local_frames;
+    uint32_t remote_frames;
+    // How many of our inputs the peer has confirmed
+    uint32_t remote_ack;
+    // Earliest simulated frame that used a wrong prediction, or UINT32_MAX
+    uint32_t rollback_from;
+
+    RollbackStats stats;
+} RollbackSession;
+
+void rollback_init(RollbackSession *session, uint64_t seed, int local, int input_delay, float dt);
+
+// False while too far ahead of the remote inputs to predict; wait for packets
+bool rollback_can_advance(const RollbackSession *session);
+// Queues this frame's local input and simulates one frame, rolling back first
+// if a prediction was wrong. Returns how many frames were resimulated, or -1
+// if it had to stall.
+int rollback_advance(RollbackSession *session, MatchInput local_input);
+
+// Our unconfirmed inputs plus an ack of theirs; sent every frame, so a lost
+// packet is covered by the next one
+size_t rollback_write_packet(const RollbackSession *session, uint8_t *packet);
+bool rollback_read_packet(RollbackSession *session, const uint8_t *packet, size_t size);
+
+// The state the frame before the current one started from, for interpolation
+const Match *rollback_previous_match(const RollbackSession *session);
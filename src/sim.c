@@ -0,0 +1,274 @@
+#include "sim.h"
+
+#include <math.h>
+
+void match_init(Match *match, uint64_t seed) {
+    *match = (Match){0};
+    match->rng = seed;
+
+    reset_paddles(match, false);
+    reset_ball(match);
+}
+
+void reset_paddles(Match *match, bool keep_score) {
+    Paddle p1 = {
+        .pos = {
+            .x = PADDLE_WIDTH + 16,
+            .y = (SCREEN_HEIGHT / 2.0) - (PADDLE_HEIGHT / 2.0)
+        },
+        .width = PADDLE_WIDTH,
+        .height = PADDLE_HEIGHT,
+        .speed = PADDLE_SPEED,
+    };
+
+    Paddle p2 = {
+        .pos = {
+            .x = SCREEN_WIDTH - PADDLE_WIDTH - 16,
+            .y = (SCREEN_HEIGHT / 2.0) - (PADDLE_HEIGHT / 2.0)
+        },
+        .width = PADDLE_WIDTH,
+        .height = PADDLE_HEIGHT,
+        .speed = PADDLE_SPEED
+    };
+
+    if (keep_score) {
+        p1.score = match->p1.score;
+        p2.score = match->p2.score;
+    }
+
+    match->p1 = p1;
+    match->p2 = p2;
+}
+
+void reset_ball(Match *match) {
+    Ball ball = {
+        .pos = {
+            .x = SCREEN_WIDTH / 2.0,
+            .y = (SCREEN_HEIGHT / 2.0 + BALL_RADIUS / 2.0)
+        },
+        .speed = BALL_SPEED,
+        .radius = BALL_RADIUS
+    };
+    set_random_dir_ball(match, &ball);
+
+    match->ball = ball;
+}
+
+void serve_ball(Match *match) {
+    match->hasStarted = true;
+    set_random_dir_ball(match, &match->ball);
+}
+
+void move_paddles(Match *match, MatchInput input, float dt) {
+    Paddle p1 = match->p1;
+    Paddle p2 = match->p2;
+
+    if (input.p1 < 0) {
+        p1.pos.y -= p1.speed * dt;
+    }
+    if (input.p1 > 0) {
+        p1.pos.y += p1.speed * dt;
+    }
+    if (input.p2 < 0) {
+        p2.pos.y -= p2.speed * dt;
+    }
+    if (input.p2 > 0) {
+        p2.pos.y += p2.speed * dt;
+    }
+
+    if (p1.pos.y <= 0) {
+        p1.pos.y += p1.speed * dt;
+    }
+    if (p1.pos.y >= SCREEN_HEIGHT - p1.height) {
+        p1.pos.y -= p1.speed * dt;
+    }
+    if (p2.pos.y <= 0) {
+        p2.pos.y += p2.speed * dt;
+    }
+    if (p2.pos.y >= SCREEN_HEIGHT - p2.height) {
+        p2.pos.y -= p2.speed * dt;
+    }
+
+    match->p1 = p1;
+    match->p2 = p2;
+}
+
+MatchEvent update_game(Match *match, float dt, float total_time) {
+    // Animate Ball
+    if (!match->hasStarted) {
+        animate_ball(match, total_time);
+        return MATCH_EVENT_NONE;
+    }
+
+    // Move ball, resolving every bounce along the way
+    Ball ball = match->ball;
+    MatchEvent event = sweep_ball(&ball, &match->p1, &match->p2, dt);
+
+    if (event == MATCH_EVENT_P2_SCORED) {
+        match->p2.score++;
+    }
+    if (event == MATCH_EVENT_P1_SCORED) {
+        match->p1.score++;
+    }
+    if (event != MATCH_EVENT_NONE) {
+        reset_paddles(match, true);
+        reset_ball(match);
+        match->hasStarted = false;
+        return event;
+    }
+
+    match->ball = ball;
+    return MATCH_EVENT_NONE;
+}
+
+static float clamp_time(float t) {
+    return t > 0 ? t : 0;
+}
+
+MatchEvent sweep_ball(Ball *ball, const Paddle *p1, const Paddle *p2, float dt) {
+    float remaining = dt;
+
+    for (int bounce = 0; bounce < MAX_BOUNCES; bounce++) {
+        float vx = ball->dir.x * ball->speed;
+        float vy = ball->dir.y * ball->speed;
+
+        // Time until each thing the ball could touch next; only surfaces it is
+        // heading into count, so it can't bounce straight back off the last one
+        float times[CONTACT_COUNT] = {
+            [CONTACT_P1] = check_collision(ball, p1, true),
+            [CONTACT_P2] = check_collision(ball, p2, false),
+            [CONTACT_TOP] = vy < 0 ? clamp_time((0 - ball->pos.y) / vy) : INFINITY,
+            [CONTACT_BOTTOM] = vy > 0 ? clamp_time((SCREEN_HEIGHT - BALL_RADIUS - ball->pos.y) / vy) : INFINITY,
+            [CONTACT_LEFT] = vx < 0 ? clamp_time((0 - ball->pos.x) / vx) : INFINITY,
+            [CONTACT_RIGHT] = vx > 0 ? clamp_time((SCREEN_WIDTH - BALL_RADIUS - ball->pos.x) / vx) : INFINITY,
+        };
+
+        Contact contact = CONTACT_NONE;
+        float t = INFINITY;
+        for (int c = 0; c < CONTACT_COUNT; c++) {
+            if (times[c] < t) {
+                t = times[c];
+                contact = c;
+            }
+        }
+
+        if (!(t <= remaining)) {
+            ball->pos.x += vx * remaining;
+            ball->pos.y += vy * remaining;
+            return MATCH_EVENT_NONE;
+        }
+
+        ball->pos.x += vx * t;
+        ball->pos.y += vy * t;
+        remaining -= t;
+
+        switch (contact) {
+            case CONTACT_P1:
+                ball->dir = reflect_vec(ball->dir, get_paddle_normal(true));
+                break;
+            case CONTACT_P2:
+                ball->dir = reflect_vec(ball->dir, get_paddle_normal(false));
+                break;
+            case CONTACT_TOP:
+            case CONTACT_BOTTOM:
+                ball->dir.y = -ball->dir.y;
+                break;
+            case CONTACT_LEFT:
+                return MATCH_EVENT_P2_SCORED;
+            case CONTACT_RIGHT:
+                return MATCH_EVENT_P1_SCORED;
+            default:
+                break;
+        }
+    }
+
+    // Out of bounces for this step: leave the ball at its last contact
+    return MATCH_EVENT_NONE;
+}
+
+MatchEvent step_match(Match *match, MatchInput input, float dt, float total_time) {
+    if (input.serve && !match->hasStarted) {
+        serve_ball(match);
+    }
+
+    move_paddles(match, input, dt);
+    return update_game(match, dt, total_time);
+}
+
+bool is_match_over(const Match *match) {
+    return match->p1.score >= WINNING_SCORE || match->p2.score >= WINNING_SCORE;
+}
+
+void animate_ball(Match *match, float total_time) {
+    match->ball.pos.y = (sin(total_time * 2) + 1) / 2 * (SCREEN_HEIGHT - 5 * BALL_RADIUS) + BALL_RADIUS;
+}
+
+uint64_t random_u64(uint64_t *rng) {
+    // splitmix64: one 64-bit word of state, so a match is cheap to copy and seed
+    uint64_t z = (*rng += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+float random_float(uint64_t *rng) {
+    return (float)(random_u64(rng) >> 40) / (float)(1 << 24);
+}
+
+void set_random_dir_ball(Match *match, Ball *ball) {
+    float x, y, length;
+
+    x = random_float(&match->rng) - 0.5;
+    y = random_float(&match->rng) - 0.5;
+
+    //Normalize the vector
+    length = sqrt(x*x + y*y);
+    x /= length;
+    y /= length;
+
+    ball->dir.x = x;
+    ball->dir.y = y;
+}
+
+float check_collision(const Ball *ball, const Paddle *p, bool is_left_side) {
+    float vx = ball->dir.x * ball->speed;
+    float t;
+
+    if (is_left_side) {
+        // Ball's left edge against the paddle's right face
+        if (!(vx < 0) || ball->pos.x < p->pos.x) {
+            return INFINITY;
+        }
+        t = (p->pos.x + p->width - ball->pos.x) / vx;
+    } else {
+        // Ball's right edge against the paddle's left face
+        float right = ball->pos.x + ball->radius;
+        if (!(vx > 0) || right > p->pos.x + p->width) {
+            return INFINITY;
+        }
+        t = (p->pos.x - right) / vx;
+    }
+    t = clamp_time(t);
+
+    float y = ball->pos.y + ball->dir.y * ball->speed * t;
+    if (y >= p->pos.y && y <= p->pos.y + p->height) {
+        return t;
+    }
+    return INFINITY;
+}
+
+Vector2D get_paddle_normal(bool is_left_side) {
+    if (is_left_side) {
+        return (Vector2D){.x = 1.0f, .y = 0};
+    }
+    return (Vector2D){.x = -1.0f, .y = 0};
+}
+
+Vector2D reflect_vec(Vector2D vec, Vector2D normal) {
+    float dot = vec.x * normal.x + vec.y * normal.y;
+    Vector2D r = {
+        vec.x - 2 * dot * normal.x,
+        vec.y - 2 * dot * normal.y
+    };
+    return r;
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Pure simulation core: no SDL, no globals. Every function takes the match it
+// operates on, so any number of matches can live in one process.
+
+typedef struct {
+    float x;
+    float y;
+} Vector2D;
+
+typedef struct {
+    Vector2D pos;
+
+    float width;
+    float height;
+    float speed;
+    int score;
+} Paddle;
+
+typedef struct {
+    Vector2D pos;
+    Vector2D dir;
+    float speed;
+    float radius;
+} Ball;
+
+typedef struct {
+    Paddle p1;
+    Paddle p2;
+
+    Ball ball;
+
+    bool hasStarted;
+    uint64_t rng;
+} Match;
+
+// Per-tick paddle commands: -1 moves up, 1 moves down, 0 holds still.
+typedef struct {
+    int8_t p1;
+    int8_t p2;
+    bool serve;
+} MatchInput;
+
+// What the ball touches first during a sweep
+typedef enum {
+    CONTACT_P1,
+    CONTACT_P2,
+    CONTACT_TOP,
+    CONTACT_BOTTOM,
+    CONTACT_LEFT,
+    CONTACT_RIGHT,
+    CONTACT_COUNT,
+    CONTACT_NONE = CONTACT_COUNT,
+} Contact;
+
+typedef enum {
+    MATCH_EVENT_NONE,
+    MATCH_EVENT_P1_SCORED,
+    MATCH_EVENT_P2_SCORED,
+} MatchEvent;
+
+#define SCREEN_WIDTH  640
+#define SCREEN_HEIGHT 480
+
+#define PADDLE_WIDTH 10
+#define PADDLE_HEIGHT 125
+#define BALL_RADIUS 15
+#define PADDLE_SPEED 300
+#define BALL_SPEED 225
+
+#define WINNING_SCORE 11
+
+// Most contacts resolved in one step before the rest of it is dropped
+#define MAX_BOUNCES 16
+
+void match_init(Match *match, uint64_t seed);
+
+void reset_paddles(Match *match, bool keep_score);
+void reset_ball(Match *match);
+void serve_ball(Match *match);
+
+void move_paddles(Match *match, MatchInput input, float dt);
+MatchEvent update_game(Match *match, float dt, float total_time);
+MatchEvent sweep_ball(Ball *ball, const Paddle *p1, const Paddle *p2, float dt);
+MatchEvent step_match(Match *match, MatchInput input, float dt, float total_time);
+bool is_match_over(const Match *match);
+
+void animate_ball(Match *match, float total_time);
+void set_random_dir_ball(Match *match, Ball *ball);
+
+uint64_t random_u64(uint64_t *rng);
+float random_float(uint64_t *rng);
+
+// Time until the ball hits the paddle's face, or INFINITY if it won't
+float check_collision(const Ball *ball, const Paddle *p, bool is_left_side);
+Vector2D get_paddle_normal(bool is_left_side);
+Vector2D reflect_vec(Vector2D vec, Vector2D normal);
+Vector2D find_vec_between_two_pos(Vector2D pos1, Vector2D po2);
@@ -0,0 +1,256 @@
+#include "sim_fixed.h"
+
+#define P1_X FIXED_INT(PADDLE_WIDTH + 16)
+#define P2_X FIXED_INT(SCREEN_WIDTH - PADDLE_WIDTH - 16)
+#define PADDLE_TOP ((FIXED_INT(SCREEN_HEIGHT) - FIXED_INT(PADDLE_HEIGHT)) / 2)
+#define PADDLE_BOTTOM FIXED_INT(SCREEN_HEIGHT - PADDLE_HEIGHT)
+#define BALL_BOTTOM FIXED_INT(SCREEN_HEIGHT - BALL_RADIUS)
+#define BALL_RIGHT FIXED_INT(SCREEN_WIDTH - BALL_RADIUS)
+
+void fixed_match_init(FixedMatch *match, uint64_t seed) {
+    *match = (FixedMatch){0};
+    match->rng = seed;
+
+    fixed_reset_paddles(match, false);
+    fixed_reset_ball(match);
+}
+
+void fixed_reset_paddles(FixedMatch *match, bool keep_score) {
+    match->p1.pos = (FixedVector){P1_X, PADDLE_TOP};
+    match->p2.pos = (FixedVector){P2_X, PADDLE_TOP};
+    if (!keep_score) {
+        match->p1.score = 0;
+        match->p2.score = 0;
+    }
+}
+
+void fixed_reset_ball(FixedMatch *match) {
+    FixedBall ball = {
+        .pos = {
+            .x = FIXED_INT(SCREEN_WIDTH) / 2,
+            .y = (FIXED_INT(SCREEN_HEIGHT) + FIXED_INT(BALL_RADIUS)) / 2
+        },
+    };
+    fixed_set_random_dir_ball(match, &ball);
+
+    match->ball = ball;
+}
+
+void fixed_serve_ball(FixedMatch *match) {
+    match->hasStarted = true;
+    fixed_set_random_dir_ball(match, &match->ball);
+}
+
+static fixed move_paddle(fixed y, int8_t command, fixed step) {
+    if (command < 0) {
+        y -= step;
+    }
+    if (command > 0) {
+        y += step;
+    }
+
+    if (y <= 0) {
+        y += step;
+    }
+    if (y >= PADDLE_BOTTOM) {
+        y -= step;
+    }
+    return y;
+}
+
+void fixed_move_paddles(FixedMatch *match, MatchInput input, fixed dt) {
+    const fixed step = PADDLE_SPEED * dt;
+    match->p1.pos.y = move_paddle(match->p1.pos.y, input.p1, step);
+    match->p2.pos.y = move_paddle(match->p2.pos.y, input.p2, step);
+}
+
+MatchEvent fixed_update_game(FixedMatch *match, fixed dt, fixed total_time) {
+    if (!match->hasStarted) {
+        fixed_animate_ball(match, total_time);
+        return MATCH_EVENT_NONE;
+    }
+
+    FixedBall ball = match->ball;
+    MatchEvent event = fixed_sweep_ball(&ball, match->p1.pos.y, match->p2.pos.y, dt);
+
+    if (event == MATCH_EVENT_P2_SCORED) {
+        match->p2.score++;
+    }
+    if (event == MATCH_EVENT_P1_SCORED) {
+        match->p1.score++;
+    }
+    if (event != MATCH_EVENT_NONE) {
+        fixed_reset_paddles(match, true);
+        fixed_reset_ball(match);
+        match->hasStarted = false;
+        return event;
+    }
+
+    match->ball = ball;
+    return MATCH_EVENT_NONE;
+}
+
+static fixed clamp_time(fixed t) {
+    return t > 0 ? t : 0;
+}
+
+MatchEvent fixed_sweep_ball(FixedBall *ball, fixed p1_y, fixed p2_y, fixed dt) {
+    fixed remaining = dt;
+
+    for (int bounce = 0; bounce < MAX_BOUNCES; bounce++) {
+        fixed vx = ball->dir.x * BALL_SPEED;
+        fixed vy = ball->dir.y * BALL_SPEED;
+
+        fixed times[CONTACT_COUNT] = {
+            [CONTACT_P1] = fixed_check_collision(ball, p1_y, true),
+            [CONTACT_P2] = fixed_check_collision(ball, p2_y, false),
+            [CONTACT_TOP] = vy < 0 ? clamp_time(fixed_div(0 - ball->pos.y, vy)) : FIXED_MAX,
+            [CONTACT_BOTTOM] = vy > 0 ? clamp_time(fixed_div(BALL_BOTTOM - ball->pos.y, vy)) : FIXED_MAX,
+            [CONTACT_LEFT] = vx < 0 ? clamp_time(fixed_div(0 - ball->pos.x, vx)) : FIXED_MAX,
+            [CONTACT_RIGHT] = vx > 0 ? clamp_time(fixed_div(BALL_RIGHT - ball->pos.x, vx)) : FIXED_MAX,
+        };
+
+        Contact contact = CONTACT_NONE;
+        fixed t = FIXED_MAX;
+        for (int c = 0; c < CONTACT_COUNT; c++) {
+            if (times[c] < t) {
+                t = times[c];
+                contact = c;
+            }
+        }
+
+        if (t > remaining) {
+            ball->pos.x += fixed_mul(vx, remaining);
+            ball->pos.y += fixed_mul(vy, remaining);
+            return MATCH_EVENT_NONE;
+        }
+
+        ball->pos.x += fixed_mul(vx, t);
+        ball->pos.y += fixed_mul(vy, t);
+        remaining -= t;
+
+        switch (contact) {
+            case CONTACT_P1:
+                ball->dir = fixed_reflect_vec(ball->dir, (FixedVector){FIXED_ONE, 0});
+                break;
+            case CONTACT_P2:
+                ball->dir = fixed_reflect_vec(ball->dir, (FixedVector){-FIXED_ONE, 0});
+                break;
+            case CONTACT_TOP:
+            case CONTACT_BOTTOM:
+                ball->dir.y = -ball->dir.y;
+                break;
+            case CONTACT_LEFT:
+                return MATCH_EVENT_P2_SCORED;
+            case CONTACT_RIGHT:
+                return MATCH_EVENT_P1_SCORED;
+            default:
+                break;
+        }
+    }
+
+    return MATCH_EVENT_NONE;
+}
+
+MatchEvent fixed_step_match(FixedMatch *match, MatchInput input, fixed dt, fixed total_time) {
+    if (input.serve && !match->hasStarted) {
+        fixed_serve_ball(match);
+    }
+
+    fixed_move_paddles(match, input, dt);
+    return fixed_update_game(match, dt, total_time);
+}
+
+bool fixed_is_match_over(const FixedMatch *match) {
+    return match->p1.score >= WINNING_SCORE || match->p2.score >= WINNING_SCORE;
+}
+
+void fixed_animate_ball(FixedMatch *match, fixed total_time) {
+    // sin(2 t) is sin of t / pi turns
+    fixed turns = (fixed)(((int64_t)total_time * INV_PI_Q32) >> 32);
+    fixed s = fixed_sin_turns(turns);
+    fixed half_range = FIXED_INT(SCREEN_HEIGHT - 5 * BALL_RADIUS) / 2;
+    match->ball.pos.y = fixed_mul(s + FIXED_ONE, half_range) + FIXED_INT(BALL_RADIUS);
+}
+
+void fixed_set_random_dir_ball(FixedMatch *match, FixedBall *ball) {
+    // The top 32 bits of the same draws random_float takes its 24 from, as
+    // -0.5..0.5 with 32 fraction bits: short vectors still normalize precisely
+    int64_t x = (int64_t)(random_u64(&match->rng) >> 32) - (1ll << 31);
+    int64_t y = (int64_t)(random_u64(&match->rng) >> 32) - (1ll << 31);
+
+    // Each square is at most 2^62, so the sum fits in 64 unsigned bits
+    int64_t length = isqrt64((uint64_t)(x * x) + (uint64_t)(y * y));
+    if (length == 0) {
+        ball->dir = (FixedVector){FIXED_ONE, 0};
+        return;
+    }
+
+    ball->dir.x = (fixed)(x * FIXED_ONE / length);
+    ball->dir.y = (fixed)(y * FIXED_ONE / length);
+}
+
+fixed fixed_check_collision(const FixedBall *ball, fixed paddle_y, bool is_left_side) {
+    fixed vx = ball->dir.x * BALL_SPEED;
+    fixed t;
+
+    if (is_left_side) {
+        if (vx >= 0 || ball->pos.x < P1_X) {
+            return FIXED_MAX;
+        }
+        t = fixed_div(P1_X + FIXED_INT(PADDLE_WIDTH) - ball->pos.x, vx);
+    } else {
+        fixed right = ball->pos.x + FIXED_INT(BALL_RADIUS);
+        if (vx <= 0 || right > P2_X + FIXED_INT(PADDLE_WIDTH)) {
+            return FIXED_MAX;
+        }
+        t = fixed_div(P2_X - right, vx);
+    }
+    t = clamp_time(t);
+    if (t == FIXED_MAX) {
+        return FIXED_MAX;
+    }
+
+    fixed y = ball->pos.y + fixed_mul(ball->dir.y * BALL_SPEED, t);
+    if (y >= paddle_y && y <= paddle_y + FIXED_INT(PADDLE_HEIGHT)) {
+        return t;
+    }
+    return FIXED_MAX;
+}
+
+FixedVector fixed_reflect_vec(FixedVector vec, FixedVector normal) {
+    fixed dot = fixed_mul(vec.x, normal.x) + fixed_mul(vec.y, normal.y);
+    return (FixedVector){
+        vec.x - 2 * fixed_mul(dot, normal.x),
+        vec.y - 2 * fixed_mul(dot, normal.y)
+    };
+}
+
+void fixed_match_to_float(const FixedMatch *match, Match *out) {
+    reset_paddles(out, false);
+    out->p1.pos.y = fixed_to_float(match->p1.pos.y);
+    out->p2.pos.y = fixed_to_float(match->p2.pos.y);
+    out->p1.score = match->p1.score;
+    out->p2.score = match->p2.score;
+
+    out->ball = (Ball){
+        .pos = {fixed_to_float(match->ball.pos.x), fixed_to_float(match->ball.pos.y)},
+        .dir = {fixed_to_float(match->ball.dir.x), fixed_to_float(match->ball.dir.y)},
+        .speed = BALL_SPEED,
+        .radius = BALL_RADIUS
+    };
+    out->hasStarted = match->hasStarted;
+    out->rng = match->rng;
+}
+
+void fixed_match_from_float(const Match *match, FixedMatch *out) {
+    out->p1.pos = (FixedVector){fixed_from_float(match->p1.pos.x), fixed_from_float(match->p1.pos.y)};
+    out->p2.pos = (FixedVector){fixed_from_float(match->p2.pos.x), fixed_from_float(match->p2.pos.y)};
+    out->p1.score = match->p1.score;
+    out->p2.score = match->p2.score;
+
+    out->ball.pos = (FixedVector){fixed_from_float(match->ball.pos.x), fixed_from_float(match->ball.pos.y)};
+    out->ball.dir = (FixedVector){fixed_from_float(match->ball.dir.x), fixed_from_float(match->ball.dir.y)};
+    out->hasStarted = match->hasStarted;
+    out->rng = match->rng;
+}
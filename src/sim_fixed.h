@@ -0,0 +1,71 @@
+#pragma once
+
+#include "fixed.h"
+#include "sim.h"
+
+// Integer-only twin of the float simulation in sim.h: the same rules and the
+// same RNG stream, with every position, direction and time in Q16.16, so a
+// match plays out identically everywhere. Paddle and ball sizes and speeds are
+// the constants from sim.h. It tracks the float path to within rounding; see
+// pong_bench fixed for the cross-check.
+
+typedef enum {
+    PHYSICS_FLOAT,
+    PHYSICS_FIXED,
+} PhysicsBackend;
+
+// Configure with -DPONG_FIXED_POINT=ON to make headless play, tournaments and
+// the batch engine use the fixed backend
+#ifdef PONG_FIXED_POINT
+#define DEFAULT_PHYSICS PHYSICS_FIXED
+#else
+#define DEFAULT_PHYSICS PHYSICS_FLOAT
+#endif
+
+typedef struct {
+    fixed x;
+    fixed y;
+} FixedVector;
+
+typedef struct {
+    FixedVector pos;
+    int score;
+} FixedPaddle;
+
+typedef struct {
+    FixedVector pos;
+    FixedVector dir;
+} FixedBall;
+
+typedef struct {
+    FixedPaddle p1;
+    FixedPaddle p2;
+
+    FixedBall ball;
+
+    bool hasStarted;
+    uint64_t rng;
+} FixedMatch;
+
+void fixed_match_init(FixedMatch *match, uint64_t seed);
+void fixed_reset_paddles(FixedMatch *match, bool keep_score);
+void fixed_reset_ball(FixedMatch *match);
+void fixed_serve_ball(FixedMatch *match);
+
+void fixed_move_paddles(FixedMatch *match, MatchInput input, fixed dt);
+MatchEvent fixed_update_game(FixedMatch *match, fixed dt, fixed total_time);
+MatchEvent fixed_sweep_ball(FixedBall *ball, fixed p1_y, fixed p2_y, fixed dt);
+MatchEvent fixed_step_match(FixedMatch *match, MatchInput input, fixed dt, fixed total_time);
+bool fixed_is_match_over(const FixedMatch *match);
+
+void fixed_animate_ball(FixedMatch *match, fixed total_time);
+void fixed_set_random_dir_ball(FixedMatch *match, FixedBall *ball);
+
+// Time until the ball hits the paddle's face, or FIXED_MAX if it won't
+fixed fixed_check_collision(const FixedBall *ball, fixed paddle_y, bool is_left_side);
+FixedVector fixed_reflect_vec(FixedVector vec, FixedVector normal);
+
+// The float Match it corresponds to, for drawing, the AI and comparisons
+void fixed_match_to_float(const FixedMatch *match, Match *out);
+// Nearest fixed state to a float one; only for cross-checking the two backends
+void fixed_match_from_float(const Match *match, FixedMatch *out);
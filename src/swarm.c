@@ -0,0 +1,310 @@
+#include "swarm.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+bool swarm_init(Swarm *swarm, int capacity, uint64_t seed) {
+    *swarm = (Swarm){
+        .capacity = capacity,
+        .free_head = -1,
+        .rng = seed,
+        .balls = malloc(capacity * sizeof(SwarmBall)),
+        .cell_start = malloc((SWARM_CELL_COUNT + 1) * sizeof(int)),
+        .cell_items = malloc(capacity * sizeof(int)),
+        .cell_pos = malloc(capacity * sizeof(Vector2D)),
+        .ball_cell = malloc(capacity * sizeof(int)),
+        .pairs = malloc(capacity * SWARM_PAIRS_PER_BALL * sizeof(SwarmPair)),
+    };
+    if (swarm->balls == NULL || swarm->cell_start == NULL || swarm->cell_items == NULL || swarm->cell_pos == NULL ||
+        swarm->ball_cell == NULL || swarm->pairs == NULL) {
+        swarm_destroy(swarm);
+        return false;
+    }
+    return true;
+}
+
+void swarm_destroy(Swarm *swarm) {
+    free(swarm->balls);
+    free(swarm->cell_start);
+    free(swarm->cell_items);
+    free(swarm->cell_pos);
+    free(swarm->ball_cell);
+    free(swarm->pairs);
+    *swarm = (Swarm){0};
+}
+
+int swarm_spawn(Swarm *swarm, Vector2D pos, Vector2D vel) {
+    int index;
+    if (swarm->free_head >= 0) {
+        index = swarm->free_head;
+        swarm->free_head = swarm->balls[index].next_free;
+    } else if (swarm->used < swarm->capacity) {
+        index = swarm->used++;
+    } else {
+        return -1;
+    }
+
+    swarm->balls[index] = (SwarmBall){.pos = pos, .vel = vel, .next_free = -1, .isAlive = true};
+    swarm->count++;
+    return index;
+}
+
+void swarm_despawn(Swarm *swarm, int index) {
+    SwarmBall *ball = &swarm->balls[index];
+    if (!ball->isAlive) {
+        return;
+    }
+    ball->isAlive = false;
+    ball->next_free = swarm->free_head;
+    swarm->free_head = index;
+    swarm->count--;
+}
+
+static Vector2D random_velocity(Swarm *swarm) {
+    // Never steeper than 45 degrees, or balls rattle between the walls for ages
+    float x = random_float(&swarm->rng) < 0.5f ? -1.0f : 1.0f;
+    float y = random_float(&swarm->rng) * 2 - 1;
+    float scale = BALL_SPEED / sqrtf(x * x + y * y);
+    return (Vector2D){x * scale, y * scale};
+}
+
+int swarm_spawn_random(Swarm *swarm, int count) {
+    for (int i = 0; i < count; i++) {
+        Vector2D pos = {
+            random_float(&swarm->rng) * (SCREEN_WIDTH - SWARM_BALL_SIZE),
+            random_float(&swarm->rng) * (SCREEN_HEIGHT - SWARM_BALL_SIZE),
+        };
+        if (swarm_spawn(swarm, pos, random_velocity(swarm)) < 0) {
+            return i;
+        }
+    }
+    return count;
+}
+
+void swarm_despawn_some(Swarm *swarm, int count) {
+    for (int i = swarm->used - 1; i >= 0 && count > 0; i--) {
+        if (swarm->balls[i].isAlive) {
+            swarm_despawn(swarm, i);
+            count--;
+        }
+    }
+}
+
+void swarm_move(Swarm *swarm, float dt) {
+    const float bottom = SCREEN_HEIGHT - SWARM_BALL_SIZE;
+    const float right = SCREEN_WIDTH - SWARM_BALL_SIZE;
+
+    for (int i = 0; i < swarm->used; i++) {
+        SwarmBall *ball = &swarm->balls[i];
+        if (!ball->isAlive) {
+            continue;
+        }
+
+        ball->pos.x += ball->vel.x * dt;
+        ball->pos.y += ball->vel.y * dt;
+
+        if (ball->pos.y < 0) {
+            ball->pos.y = -ball->pos.y;
+            ball->vel.y = fabsf(ball->vel.y);
+        }
+        if (ball->pos.y > bottom) {
+            ball->pos.y = 2 * bottom - ball->pos.y;
+            ball->vel.y = -fabsf(ball->vel.y);
+        }
+
+        // Out at either end: serve it again from the middle
+        if (ball->pos.x < 0 || ball->pos.x > right) {
+            ball->pos = (Vector2D){SCREEN_WIDTH / 2.0f, random_float(&swarm->rng) * bottom};
+            ball->vel = random_velocity(swarm);
+            swarm->stats.scored++;
+        }
+    }
+}
+
+static int clamp_int(int v, int low, int high) {
+    return v < low ? low : v > high ? high : v;
+}
+
+static int cell_column(float x) {
+    return clamp_int((int)floorf(x / SWARM_CELL_SIZE), 0, SWARM_GRID_COLUMNS - 1);
+}
+
+static int cell_row(float y) {
+    return clamp_int((int)floorf(y / SWARM_CELL_SIZE), 0, SWARM_GRID_ROWS - 1);
+}
+
+void swarm_build_grid(Swarm *swarm) {
+    int *start = swarm->cell_start;
+    memset(start, 0, (SWARM_CELL_COUNT + 1) * sizeof(int));
+
+    // Counting sort by the cell under each ball's center
+    for (int i = 0; i < swarm->used; i++) {
+        const SwarmBall *ball = &swarm->balls[i];
+        if (!ball->isAlive) {
+            continue;
+        }
+        float half = SWARM_BALL_SIZE / 2.0f;
+        int cell = cell_row(ball->pos.y + half) * SWARM_GRID_COLUMNS + cell_column(ball->pos.x + half);
+        swarm->ball_cell[i] = cell;
+        start[cell]++;
+    }
+
+    // Each cell's end, then walk back so each ends up at its start
+    int total = 0;
+    for (int c = 0; c < SWARM_CELL_COUNT; c++) {
+        total += start[c];
+        start[c] = total;
+    }
+    start[SWARM_CELL_COUNT] = total;
+    for (int i = swarm->used - 1; i >= 0; i--) {
+        if (swarm->balls[i].isAlive) {
+            int slot = --start[swarm->ball_cell[i]];
+            swarm->cell_items[slot] = i;
+            swarm->cell_pos[slot] = swarm->balls[i].pos;
+        }
+    }
+}
+
+// i and j are places in the grid, not slots in the pool
+static void test_pair(Swarm *swarm, int i, int j) {
+    const Vector2D pa = swarm->cell_pos[i];
+    const Vector2D pb = swarm->cell_pos[j];
+
+    if (fabsf(pa.x - pb.x) >= SWARM_BALL_SIZE || fabsf(pa.y - pb.y) >= SWARM_BALL_SIZE) {
+        return;
+    }
+    swarm->stats.contacts++;
+    if (swarm->pair_count < swarm->capacity * SWARM_PAIRS_PER_BALL) {
+        swarm->pairs[swarm->pair_count++] = (SwarmPair){swarm->cell_items[i], swarm->cell_items[j]};
+    }
+}
+
+int swarm_find_contacts(Swarm *swarm) {
+    // The cell itself, then the neighbours ahead of it, so each pair comes up once
+    static const int ahead[][2] = {{1, 0}, {-1, 1}, {0, 1}, {1, 1}};
+    const int *start = swarm->cell_start;
+
+    swarm->pair_count = 0;
+    // Only occupied cells: the grid lists balls cell by cell, so jump from one run to the next
+    for (int first = 0; first < start[SWARM_CELL_COUNT];) {
+        int cell = swarm->ball_cell[swarm->cell_items[first]];
+        int end = start[cell + 1];
+        int row = cell / SWARM_GRID_COLUMNS;
+        int column = cell % SWARM_GRID_COLUMNS;
+
+        swarm->stats.candidates += (end - first) * (end - first - 1) / 2;
+        for (int i = first; i < end; i++) {
+            for (int j = i + 1; j < end; j++) {
+                test_pair(swarm, i, j);
+            }
+        }
+
+        for (int n = 0; n < 4; n++) {
+            int c = column + ahead[n][0];
+            int r = row + ahead[n][1];
+            if (c < 0 || c >= SWARM_GRID_COLUMNS || r >= SWARM_GRID_ROWS) {
+                continue;
+            }
+            int other = r * SWARM_GRID_COLUMNS + c;
+            swarm->stats.candidates += (end - first) * (start[other + 1] - start[other]);
+            for (int i = first; i < end; i++) {
+                for (int j = start[other]; j < start[other + 1]; j++) {
+                    test_pair(swarm, i, j);
+                }
+            }
+        }
+        first = end;
+    }
+    return swarm->pair_count;
+}
+
+void swarm_resolve_contacts(Swarm *swarm) {
+    for (int p = 0; p < swarm->pair_count; p++) {
+        SwarmBall *a = &swarm->balls[swarm->pairs[p].a];
+        SwarmBall *b = &swarm->balls[swarm->pairs[p].b];
+        float dx = b->pos.x - a->pos.x;
+        float dy = b->pos.y - a->pos.y;
+        float overlap_x = SWARM_BALL_SIZE - fabsf(dx);
+        float overlap_y = SWARM_BALL_SIZE - fabsf(dy);
+        // An earlier pair may already have pushed these two apart
+        if (overlap_x <= 0 || overlap_y <= 0) {
+            continue;
+        }
+
+        // Push apart along the shallower axis; equal masses trade velocities
+        // along it if they are closing in
+        if (overlap_x < overlap_y) {
+            float side = dx < 0 ? -1.0f : 1.0f;
+            a->pos.x -= side * overlap_x / 2;
+            b->pos.x += side * overlap_x / 2;
+            if ((b->vel.x - a->vel.x) * side < 0) {
+                float v = a->vel.x;
+                a->vel.x = b->vel.x;
+                b->vel.x = v;
+            }
+        } else {
+            float side = dy < 0 ? -1.0f : 1.0f;
+            a->pos.y -= side * overlap_y / 2;
+            b->pos.y += side * overlap_y / 2;
+            if ((b->vel.y - a->vel.y) * side < 0) {
+                float v = a->vel.y;
+                a->vel.y = b->vel.y;
+                b->vel.y = v;
+            }
+        }
+    }
+}
+
+static void hit_paddle(Swarm *swarm, const Paddle *paddle, bool is_left_side) {
+    const float half = SWARM_BALL_SIZE / 2.0f;
+    const Vector2D pos = paddle->pos;
+
+    // Cells any touching ball's center can be in, plus one for balls the
+    // contacts moved since the grid was built
+    int first_column = cell_column(pos.x - half) - 1;
+    int last_column = cell_column(pos.x + paddle->width + half) + 1;
+    int first_row = cell_row(pos.y - half) - 1;
+    int last_row = cell_row(pos.y + paddle->height + half) + 1;
+
+    for (int row = clamp_int(first_row, 0, SWARM_GRID_ROWS - 1); row <= clamp_int(last_row, 0, SWARM_GRID_ROWS - 1);
+         row++) {
+        for (int column = clamp_int(first_column, 0, SWARM_GRID_COLUMNS - 1);
+             column <= clamp_int(last_column, 0, SWARM_GRID_COLUMNS - 1); column++) {
+            int cell = row * SWARM_GRID_COLUMNS + column;
+
+            for (int i = swarm->cell_start[cell]; i < swarm->cell_start[cell + 1]; i++) {
+                SwarmBall *ball = &swarm->balls[swarm->cell_items[i]];
+                swarm->stats.candidates++;
+                if (ball->pos.x >= pos.x + paddle->width || ball->pos.x + SWARM_BALL_SIZE <= pos.x ||
+                    ball->pos.y >= pos.y + paddle->height || ball->pos.y + SWARM_BALL_SIZE <= pos.y) {
+                    continue;
+                }
+
+                if (is_left_side) {
+                    ball->pos.x = pos.x + paddle->width;
+                    ball->vel.x = fabsf(ball->vel.x);
+                } else {
+                    ball->pos.x = pos.x - SWARM_BALL_SIZE;
+                    ball->vel.x = -fabsf(ball->vel.x);
+                }
+                swarm->stats.paddle_hits++;
+            }
+        }
+    }
+}
+
+void swarm_hit_paddles(Swarm *swarm, const Paddle *p1, const Paddle *p2) {
+    hit_paddle(swarm, p1, true);
+    hit_paddle(swarm, p2, false);
+}
+
+void swarm_step(Swarm *swarm, const Paddle *p1, const Paddle *p2, float dt) {
+    swarm->stats = (SwarmStats){0};
+
+    swarm_move(swarm, dt);
+    swarm_build_grid(swarm);
+    swarm_find_contacts(swarm);
+    swarm_resolve_contacts(swarm);
+    swarm_hit_paddles(swarm, p1, p2);
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "sim.h"
+
+// Stress mode: thousands of small balls on the field at once, bouncing off the
+// walls, the paddles and each other. Balls live in a pool allocated up front
+// and reused through a free list, so spawning and despawning never allocate.
+// Contacts are found through a uniform grid rebuilt every step, so a step
+// costs O(balls) instead of checking every pair.
+
+#define SWARM_BALL_SIZE 4
+// No smaller than a ball, so touching balls are always in neighbouring cells;
+// any bigger only adds candidates
+#define SWARM_CELL_SIZE SWARM_BALL_SIZE
+#define SWARM_GRID_COLUMNS (SCREEN_WIDTH / SWARM_CELL_SIZE)
+#define SWARM_GRID_ROWS (SCREEN_HEIGHT / SWARM_CELL_SIZE)
+#define SWARM_CELL_COUNT (SWARM_GRID_COLUMNS * SWARM_GRID_ROWS)
+#define SWARM_MAX_BALLS 16384
+// Room for this many touching pairs per ball; more are left for the next step
+#define SWARM_PAIRS_PER_BALL 4
+
+typedef struct {
+    Vector2D pos;
+    Vector2D vel;
+    // Next slot on the free list while not in play, -1 at its end
+    int next_free;
+    bool isAlive;
+} SwarmBall;
+
+typedef struct {
+    int a;
+    int b;
+} SwarmPair;
+
+// Counts for the last step
+typedef struct {
+    // Pairs the grid put next to each other, balls and paddles included
+    long long candidates;
+    // Of those, pairs that were actually touching
+    long long contacts;
+    int paddle_hits;
+    // Balls that went out at either end and were served again
+    int scored;
+} SwarmStats;
+
+typedef struct {
+    SwarmBall *balls;
+    int capacity;
+    int count;
+    // Slots past this have never been used, so loops stop here
+    int used;
+    int free_head;
+    uint64_t rng;
+
+    // Balls of cell c are cell_items[cell_start[c]] up to cell_items[cell_start[c + 1]],
+    // and cell_pos holds their positions in the same order, for scanning without
+    // jumping around the pool
+    int *cell_start;
+    int *cell_items;
+    Vector2D *cell_pos;
+    int *ball_cell;
+
+    SwarmPair *pairs;
+    int pair_count;
+
+    SwarmStats stats;
+} Swarm;
+
+bool swarm_init(Swarm *swarm, int capacity, uint64_t seed);
+void swarm_destroy(Swarm *swarm);
+
+// The slot it took, or -1 when the pool is full
+int swarm_spawn(Swarm *swarm, Vector2D pos, Vector2D vel);
+void swarm_despawn(Swarm *swarm, int index);
+// Spawns count balls at random places, heading in random directions; returns how many fit
+int swarm_spawn_random(Swarm *swarm, int count);
+// Despawns up to count balls, the most recently used slots first
+void swarm_despawn_some(Swarm *swarm, int count);
+
+void swarm_step(Swarm *swarm, const Paddle *p1, const Paddle *p2, float dt);
+
+// The phases of swarm_step, in order, for the benchmarks
+void swarm_move(Swarm *swarm, float dt);
+void swarm_build_grid(Swarm *swarm);
+int swarm_find_contacts(Swarm *swarm);
+void swarm_resolve_contacts(Swarm *swarm);
+void swarm_hit_paddles(Swarm *swarm, const Paddle *p1, const Paddle *p2);
@@ -0,0 +1,371 @@
+#include "thread_pool.h"
+
+#include <stdatomic.h>
+#include <stdlib.h>
+
+// The few threading primitives the pool needs, on Win32 or pthreads
+#ifdef _WIN32
+#include <windows.h>
+typedef HANDLE Thread;
+typedef SRWLOCK Mutex;
+typedef CONDITION_VARIABLE Condition;
+typedef LPTHREAD_START_ROUTINE ThreadMain;
+#define WORKER_RESULT DWORD WINAPI
+#define WORKER_DONE 0
+#else
+#include <pthread.h>
+#include <unistd.h>
+typedef pthread_t Thread;
+typedef pthread_mutex_t Mutex;
+typedef pthread_cond_t Condition;
+typedef void *(*ThreadMain)(void *);
+#define WORKER_RESULT void *
+#define WORKER_DONE NULL
+#endif
+
+#define TASK_EMPTY (-1)
+#define TASK_ABORT (-2)
+
+// Tasks are all pushed before the workers are woken, so the slots never
+// change while anyone might steal them; only top and bottom are contended.
+typedef struct {
+    _Atomic int64_t top;
+    _Atomic int64_t bottom;
+    int *tasks;
+    int64_t capacity;
+} TaskDeque;
+
+typedef struct {
+    ThreadPool *pool;
+    int index;
+} Worker;
+
+struct ThreadPool {
+    int thread_count;
+    Thread *threads;
+    Worker *workers;
+    TaskDeque *deques;
+    WorkerStats *stats;
+
+    Mutex lock;
+    Condition start;
+    Condition finished;
+    unsigned generation;
+    int busy;
+    bool quit;
+
+    TaskFn fn;
+    void *context;
+};
+
+static void mutex_init(Mutex *mutex) {
+#ifdef _WIN32
+    InitializeSRWLock(mutex);
+#else
+    pthread_mutex_init(mutex, NULL);
+#endif
+}
+
+static void mutex_destroy(Mutex *mutex) {
+#ifdef _WIN32
+    // SRW locks hold no resources
+    (void)mutex;
+#else
+    pthread_mutex_destroy(mutex);
+#endif
+}
+
+static void mutex_lock(Mutex *mutex) {
+#ifdef _WIN32
+    AcquireSRWLockExclusive(mutex);
+#else
+    pthread_mutex_lock(mutex);
+#endif
+}
+
+static void mutex_unlock(Mutex *mutex) {
+#ifdef _WIN32
+    ReleaseSRWLockExclusive(mutex);
+#else
+    pthread_mutex_unlock(mutex);
+#endif
+}
+
+static void condition_init(Condition *condition) {
+#ifdef _WIN32
+    InitializeConditionVariable(condition);
+#else
+    pthread_cond_init(condition, NULL);
+#endif
+}
+
+static void condition_destroy(Condition *condition) {
+#ifdef _WIN32
+    (void)condition;
+#else
+    pthread_cond_destroy(condition);
+#endif
+}
+
+static void condition_wait(Condition *condition, Mutex *mutex) {
+#ifdef _WIN32
+    SleepConditionVariableSRW(condition, mutex, INFINITE, 0);
+#else
+    pthread_cond_wait(condition, mutex);
+#endif
+}
+
+static void condition_signal(Condition *condition) {
+#ifdef _WIN32
+    WakeConditionVariable(condition);
+#else
+    pthread_cond_signal(condition);
+#endif
+}
+
+static void condition_broadcast(Condition *condition) {
+#ifdef _WIN32
+    WakeAllConditionVariable(condition);
+#else
+    pthread_cond_broadcast(condition);
+#endif
+}
+
+static bool thread_start(Thread *thread, ThreadMain fn, void *arg) {
+#ifdef _WIN32
+    *thread = CreateThread(NULL, 0, fn, arg, 0, NULL);
+    return *thread != NULL;
+#else
+    return pthread_create(thread, NULL, fn, arg) == 0;
+#endif
+}
+
+static void thread_join(Thread thread) {
+#ifdef _WIN32
+    WaitForSingleObject(thread, INFINITE);
+    CloseHandle(thread);
+#else
+    pthread_join(thread, NULL);
+#endif
+}
+
+static void deque_push(TaskDeque *d, int task) {
+    int64_t b = atomic_load_explicit(&d->bottom, memory_order_relaxed);
+    d->tasks[b % d->capacity] = task;
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
+}
+
+static int deque_pop(TaskDeque *d) {
+    int64_t b = atomic_load_explicit(&d->bottom, memory_order_relaxed) - 1;
+    atomic_store_explicit(&d->bottom, b, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    int64_t t = atomic_load_explicit(&d->top, memory_order_relaxed);
+
+    if (t > b) {
+        atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
+        return TASK_EMPTY;
+    }
+
+    int task = d->tasks[b % d->capacity];
+    if (t == b) {
+        // Last task: race any thief for it
+        if (!atomic_compare_exchange_strong_explicit(&d->top, &t, t + 1, memory_order_seq_cst, memory_order_relaxed)) {
+            task = TASK_EMPTY;
+        }
+        atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
+    }
+    return task;
+}
+
+static int deque_steal(TaskDeque *d) {
+    int64_t t = atomic_load_explicit(&d->top, memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);
+    int64_t b = atomic_load_explicit(&d->bottom, memory_order_acquire);
+
+    if (t >= b) {
+        return TASK_EMPTY;
+    }
+
+    int task = d->tasks[t % d->capacity];
+    if (!atomic_compare_exchange_strong_explicit(&d->top, &t, t + 1, memory_order_seq_cst, memory_order_relaxed)) {
+        return TASK_ABORT;
+    }
+    return task;
+}
+
+static int next_task(ThreadPool *pool, int self) {
+    int task = deque_pop(&pool->deques[self]);
+    if (task != TASK_EMPTY) {
+        return task;
+    }
+
+    // Nothing left locally. No new tasks appear mid-run, so one sweep that
+    // finds every deque empty means we're done.
+    bool retry;
+    do {
+        retry = false;
+        for (int i = 1; i < pool->thread_count; i++) {
+            int victim = (self + i) % pool->thread_count;
+            task = deque_steal(&pool->deques[victim]);
+            if (task >= 0) {
+                pool->stats[self].steals++;
+                return task;
+            }
+            if (task == TASK_ABORT) {
+                retry = true;
+            }
+        }
+    } while (retry);
+
+    return TASK_EMPTY;
+}
+
+static WORKER_RESULT worker_main(void *arg) {
+    Worker *worker = arg;
+    ThreadPool *pool = worker->pool;
+    unsigned seen_generation = 0;
+
+    for (;;) {
+        mutex_lock(&pool->lock);
+        while (!pool->quit && pool->generation == seen_generation) {
+            condition_wait(&pool->start, &pool->lock);
+        }
+        if (pool->quit) {
+            mutex_unlock(&pool->lock);
+            return WORKER_DONE;
+        }
+        seen_generation = pool->generation;
+        mutex_unlock(&pool->lock);
+
+        int task;
+        while ((task = next_task(pool, worker->index)) != TASK_EMPTY) {
+            pool->fn(pool->context, task, worker->index);
+            pool->stats[worker->index].tasks_run++;
+        }
+
+        mutex_lock(&pool->lock);
+        if (--pool->busy == 0) {
+            condition_signal(&pool->finished);
+        }
+        mutex_unlock(&pool->lock);
+    }
+}
+
+ThreadPool *thread_pool_create(int thread_count) {
+    ThreadPool *pool = calloc(1, sizeof(ThreadPool));
+    if (pool == NULL) {
+        return NULL;
+    }
+
+    pool->thread_count = thread_count;
+    pool->threads = calloc(thread_count, sizeof(Thread));
+    pool->workers = calloc(thread_count, sizeof(Worker));
+    pool->deques = calloc(thread_count, sizeof(TaskDeque));
+    pool->stats = calloc(thread_count, sizeof(WorkerStats));
+    if (!pool->threads || !pool->workers || !pool->deques || !pool->stats) {
+        free(pool->threads);
+        free(pool->workers);
+        free(pool->deques);
+        free(pool->stats);
+        free(pool);
+        return NULL;
+    }
+
+    mutex_init(&pool->lock);
+    condition_init(&pool->start);
+    condition_init(&pool->finished);
+
+    for (int i = 0; i < thread_count; i++) {
+        pool->workers[i] = (Worker){.pool = pool, .index = i};
+        if (!thread_start(&pool->threads[i], worker_main, &pool->workers[i])) {
+            pool->thread_count = i;
+            thread_pool_destroy(pool);
+            return NULL;
+        }
+    }
+
+    return pool;
+}
+
+void thread_pool_destroy(ThreadPool *pool) {
+    if (pool == NULL) {
+        return;
+    }
+
+    mutex_lock(&pool->lock);
+    pool->quit = true;
+    condition_broadcast(&pool->start);
+    mutex_unlock(&pool->lock);
+
+    for (int i = 0; i < pool->thread_count; i++) {
+        thread_join(pool->threads[i]);
+    }
+
+    for (int i = 0; i < pool->thread_count; i++) {
+        free(pool->deques[i].tasks);
+    }
+
+    mutex_destroy(&pool->lock);
+    condition_destroy(&pool->start);
+    condition_destroy(&pool->finished);
+
+    free(pool->threads);
+    free(pool->workers);
+    free(pool->deques);
+    free(pool->stats);
+    free(pool);
+}
+
+bool thread_pool_run(ThreadPool *pool, int task_count, TaskFn fn, void *context) {
+    // Deal the tasks out round-robin; stealing evens out whatever is uneven
+    int64_t capacity = task_count / pool->thread_count + 1;
+    for (int i = 0; i < pool->thread_count; i++) {
+        TaskDeque *d = &pool->deques[i];
+        if (d->capacity < capacity) {
+            int *tasks = realloc(d->tasks, capacity * sizeof(int));
+            if (tasks == NULL) {
+                return false;
+            }
+            d->tasks = tasks;
+            d->capacity = capacity;
+        }
+        atomic_store(&d->top, 0);
+        atomic_store(&d->bottom, 0);
+    }
+    for (int task = 0; task < task_count; task++) {
+        deque_push(&pool->deques[task % pool->thread_count], task);
+    }
+
+    mutex_lock(&pool->lock);
+    pool->fn = fn;
+    pool->context = context;
+    pool->busy = pool->thread_count;
+    pool->generation++;
+    condition_broadcast(&pool->start);
+    while (pool->busy > 0) {
+        condition_wait(&pool->finished, &pool->lock);
+    }
+    mutex_unlock(&pool->lock);
+
+    return true;
+}
+
+int thread_pool_size(const ThreadPool *pool) {
+    return pool->thread_count;
+}
+
+const WorkerStats *thread_pool_stats(const ThreadPool *pool, int worker) {
+    return &pool->stats[worker];
+}
+
+int hardware_thread_count() {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    int count = (int)info.dwNumberOfProcessors;
+#else
+    int count = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    return count > 0 ? count : 1;
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Work-stealing thread pool for batches of independent tasks. Each worker owns
+// a Chase-Lev deque: it pops from the bottom of its own and, once that runs
+// dry, steals from the top of the others.
+
+typedef void (*TaskFn)(void *context, int task, int worker);
+
+typedef struct {
+    long long tasks_run;
+    long long steals;
+} WorkerStats;
+
+typedef struct ThreadPool ThreadPool;
+
+ThreadPool *thread_pool_create(int thread_count);
+void thread_pool_destroy(ThreadPool *pool);
+
+// Runs fn for every task in [0, task_count) and returns once all are done.
+bool thread_pool_run(ThreadPool *pool, int task_count, TaskFn fn, void *context);
+
+int thread_pool_size(const ThreadPool *pool);
+const WorkerStats *thread_pool_stats(const ThreadPool *pool, int worker);
+
+int hardware_thread_count();
@@ -0,0 +1,10 @@
+#pragma once
+
+#include <time.h>
+
+// Wall-clock seconds for the SDL-free tools, where SDL_GetPerformanceCounter isn't available
+static inline double timer_seconds() {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
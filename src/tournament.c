@@ -0,0 +1,234 @@
+#include "tournament.h"
+
+#include "timer.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+const Entrant tournament_entrants[] = {
+    {.name = "oracle", .profile = {.kind = PLAYER_CPU, .aim_error = 1.1f, .reaction_time = 0.1f}},
+    {.name = "ace", .profile = {.kind = PLAYER_AI, .aim_error = 1.1f}},
+    {.name = "reader", .profile = {.kind = PLAYER_CPU, .aim_error = 1.3f, .reaction_time = 0.25f}},
+    {.name = "pro", .profile = {.kind = PLAYER_AI, .aim_error = 1.2f}},
+    {.name = "veteran", .profile = {.kind = PLAYER_AI, .aim_error = 1.3f}},
+    {.name = "club", .profile = {.kind = PLAYER_AI, .aim_error = 1.4f}},
+    {.name = "amateur", .profile = {.kind = PLAYER_AI, .aim_error = 1.6f}},
+    {.name = "casual", .profile = {.kind = PLAYER_AI, .aim_error = 1.8f}},
+    {.name = "rookie", .profile = {.kind = PLAYER_AI, .aim_error = 2.0f}},
+    {.name = "sweeper", .profile = {.kind = PLAYER_SCRIPT}},
+};
+const int tournament_entrant_count = sizeof(tournament_entrants) / sizeof(tournament_entrants[0]);
+
+typedef struct {
+    int p1;
+    int p2;
+    uint64_t seed;
+} Fixture;
+
+typedef struct {
+    const Fixture *fixtures;
+    // One slot per fixture, written only by whichever worker plays it
+    MatchResult *results;
+    float dt;
+} Job;
+
+bool parse_tournament_format(const char *name, TournamentFormat *format) {
+    if (strcmp(name, "round-robin") == 0) {
+        *format = FORMAT_ROUND_ROBIN;
+        return true;
+    }
+    if (strcmp(name, "ladder") == 0) {
+        *format = FORMAT_LADDER;
+        return true;
+    }
+    return false;
+}
+
+static uint64_t fixture_seed(uint64_t seed, int index) {
+    // Every fixture gets its own RNG stream, keyed by its position in the
+    // schedule rather than by the worker that happens to play it
+    uint64_t stream = seed ^ ((uint64_t)index * 0xD1B54A32D192ED03ull);
+    return random_u64(&stream);
+}
+
+static uint64_t mix_digest(uint64_t digest, uint64_t value) {
+    uint64_t state = digest ^ value;
+    return random_u64(&state);
+}
+
+static void play_fixture(void *context, int task, int worker) {
+    (void)worker;
+    const Job *job = context;
+    const Fixture *fixture = &job->fixtures[task];
+
+    play_match(fixture->seed, &tournament_entrants[fixture->p1].profile, &tournament_entrants[fixture->p2].profile,
+               job->dt, DEFAULT_PHYSICS, &job->results[task], NULL);
+}
+
+// Folds results into the standings in schedule order, so the totals come out
+// the same whichever thread played what.
+static void reduce_results(const Fixture *fixtures, const MatchResult *results, int count, TournamentResult *result) {
+    for (int i = 0; i < count; i++) {
+        const MatchResult *r = &results[i];
+        Standing *p1 = &result->standings[fixtures[i].p1];
+        Standing *p2 = &result->standings[fixtures[i].p2];
+
+        p1->played++;
+        p2->played++;
+        if (r->p1_score > r->p2_score) {
+            p1->wins++;
+        } else {
+            p2->wins++;
+        }
+        p1->points_for += r->p1_score;
+        p1->points_against += r->p2_score;
+        p2->points_for += r->p2_score;
+        p2->points_against += r->p1_score;
+
+        Standing *players[] = {p1, p2};
+        for (int p = 0; p < 2; p++) {
+            players[p]->hits += r->hits;
+            players[p]->duration += r->duration;
+            if (r->longest_rally > players[p]->longest_rally) {
+                players[p]->longest_rally = r->longest_rally;
+            }
+        }
+
+        result->matches++;
+        result->ticks += r->ticks;
+        result->points += r->points;
+        result->digest = mix_digest(result->digest, ((uint64_t)r->p1_score << 32) | (uint32_t)r->p2_score);
+        result->digest = mix_digest(result->digest, (uint64_t)r->ticks);
+        result->digest = mix_digest(result->digest, (uint64_t)r->hits);
+    }
+}
+
+static bool play_fixtures(ThreadPool *pool, const Fixture *fixtures, int count, float dt, TournamentResult *result,
+                          MatchResult *results) {
+    Job job = {.fixtures = fixtures, .results = results, .dt = dt};
+    if (!thread_pool_run(pool, count, play_fixture, &job)) {
+        return false;
+    }
+
+    reduce_results(fixtures, results, count, result);
+    return true;
+}
+
+static bool run_round_robin(ThreadPool *pool, const TournamentOptions *options, TournamentResult *result) {
+    const int n = tournament_entrant_count;
+    const int count = n * (n - 1) * options->games;
+
+    Fixture *fixtures = malloc(count * sizeof(Fixture));
+    MatchResult *results = malloc(count * sizeof(MatchResult));
+    if (fixtures == NULL || results == NULL) {
+        free(fixtures);
+        free(results);
+        return false;
+    }
+
+    int index = 0;
+    for (int p1 = 0; p1 < n; p1++) {
+        for (int p2 = 0; p2 < n; p2++) {
+            if (p1 == p2) {
+                continue;
+            }
+            for (int g = 0; g < options->games; g++) {
+                fixtures[index] = (Fixture){.p1 = p1, .p2 = p2, .seed = fixture_seed(options->seed, index)};
+                index++;
+            }
+        }
+    }
+
+    bool ok = play_fixtures(pool, fixtures, count, options->dt, result, results);
+
+    free(fixtures);
+    free(results);
+    return ok;
+}
+
+static bool run_ladder(ThreadPool *pool, const TournamentOptions *options, TournamentResult *result) {
+    const int n = tournament_entrant_count;
+    const int max_count = (n / 2) * options->games;
+
+    Fixture *fixtures = malloc(max_count * sizeof(Fixture));
+    MatchResult *results = malloc(max_count * sizeof(MatchResult));
+    if (fixtures == NULL || results == NULL) {
+        free(fixtures);
+        free(results);
+        return false;
+    }
+
+    for (int i = 0; i < n; i++) {
+        result->ladder[i] = i;
+    }
+
+    int scheduled = 0;
+    bool ok = true;
+    for (int round = 0; round < options->rounds && ok; round++) {
+        // Neighbours on the ladder play each other; alternate the pairing
+        // offset so everyone can climb past the rung above them
+        int count = 0;
+        for (int rung = round % 2; rung + 1 < n; rung += 2) {
+            for (int g = 0; g < options->games; g++) {
+                int upper = result->ladder[rung];
+                int lower = result->ladder[rung + 1];
+                bool upper_left = g % 2 == 0;
+                fixtures[count++] = (Fixture){
+                    .p1 = upper_left ? upper : lower,
+                    .p2 = upper_left ? lower : upper,
+                    .seed = fixture_seed(options->seed, scheduled++)
+                };
+            }
+        }
+
+        ok = play_fixtures(pool, fixtures, count, options->dt, result, results);
+
+        for (int i = 0; i < count; i += options->games) {
+            int rung = round % 2 + (i / options->games) * 2;
+            int lower = result->ladder[rung + 1];
+            int lower_wins = 0;
+            for (int g = 0; g < options->games; g++) {
+                const Fixture *f = &fixtures[i + g];
+                const MatchResult *r = &results[i + g];
+                int winner = r->p1_score > r->p2_score ? f->p1 : f->p2;
+                lower_wins += winner == lower;
+            }
+            if (lower_wins * 2 > options->games) {
+                result->ladder[rung + 1] = result->ladder[rung];
+                result->ladder[rung] = lower;
+            }
+        }
+    }
+
+    free(fixtures);
+    free(results);
+    return ok;
+}
+
+bool run_tournament(ThreadPool *pool, const TournamentOptions *options, TournamentResult *result) {
+    *result = (TournamentResult){0};
+    result->entrant_count = tournament_entrant_count;
+    result->standings = calloc(tournament_entrant_count, sizeof(Standing));
+    result->ladder = calloc(tournament_entrant_count, sizeof(int));
+    if (result->standings == NULL || result->ladder == NULL) {
+        free_tournament_result(result);
+        return false;
+    }
+
+    double start = timer_seconds();
+    bool ok = options->format == FORMAT_LADDER ? run_ladder(pool, options, result)
+                                               : run_round_robin(pool, options, result);
+    result->elapsed = timer_seconds() - start;
+
+    if (!ok) {
+        free_tournament_result(result);
+    }
+    return ok;
+}
+
+void free_tournament_result(TournamentResult *result) {
+    free(result->standings);
+    free(result->ladder);
+    result->standings = NULL;
+    result->ladder = NULL;
+}
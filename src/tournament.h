@@ -0,0 +1,56 @@
+#pragma once
+
+#include "headless.h"
+#include "thread_pool.h"
+
+typedef enum {
+    FORMAT_ROUND_ROBIN,
+    FORMAT_LADDER,
+} TournamentFormat;
+
+typedef struct {
+    const char *name;
+    PlayerProfile profile;
+} Entrant;
+
+typedef struct {
+    TournamentFormat format;
+    // Matches per pairing; round robin plays each pairing from both sides
+    int games;
+    int rounds;
+    int threads;
+    uint64_t seed;
+    float dt;
+} TournamentOptions;
+
+typedef struct {
+    int played;
+    int wins;
+    int points_for;
+    int points_against;
+    long long hits;
+    int longest_rally;
+    double duration;
+} Standing;
+
+typedef struct {
+    int entrant_count;
+    Standing *standings;
+    // Final ranking for ladders, best first
+    int *ladder;
+
+    int matches;
+    long long ticks;
+    long long points;
+    uint64_t digest;
+    double elapsed;
+} TournamentResult;
+
+extern const Entrant tournament_entrants[];
+extern const int tournament_entrant_count;
+
+bool parse_tournament_format(const char *name, TournamentFormat *format);
+
+// Results depend only on the options' seed, never on the thread count.
+bool run_tournament(ThreadPool *pool, const TournamentOptions *options, TournamentResult *result);
+void free_tournament_result(TournamentResult *result);
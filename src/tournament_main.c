@@ -0,0 +1,163 @@
+#include "tournament.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void print_usage(const char *program) {
+    fprintf(stderr,
+            "Usage: %s [--format round-robin|ladder] [--games N] [--rounds N] [--threads N] [--seed S] [--dt SECONDS]"
+            " [--scaling]\n",
+            program);
+}
+
+static bool better_standing(const Standing *a, const Standing *b) {
+    if (a->wins != b->wins) {
+        return a->wins > b->wins;
+    }
+    return a->points_for - a->points_against > b->points_for - b->points_against;
+}
+
+static void print_standings(const TournamentOptions *options, const TournamentResult *result) {
+    printf("%-4s %-10s %6s %5s %7s %7s %9s %8s\n", "rank", "entrant", "played", "wins", "for", "against", "avg rally",
+           "longest");
+
+    // Ladders rank by final rung, round robins by wins then point difference
+    int order[result->entrant_count];
+    for (int rank = 0; rank < result->entrant_count; rank++) {
+        order[rank] = options->format == FORMAT_LADDER ? result->ladder[rank] : rank;
+    }
+    if (options->format == FORMAT_ROUND_ROBIN) {
+        for (int i = 1; i < result->entrant_count; i++) {
+            for (int j = i; j > 0 && better_standing(&result->standings[order[j]], &result->standings[order[j - 1]]); j--) {
+                int swap = order[j];
+                order[j] = order[j - 1];
+                order[j - 1] = swap;
+            }
+        }
+    }
+
+    for (int rank = 0; rank < result->entrant_count; rank++) {
+        int i = order[rank];
+        const Standing *s = &result->standings[i];
+        int points = s->points_for + s->points_against;
+
+        printf("%-4d %-10s %6d %5d %7d %7d %9.2f %8d\n", rank + 1, tournament_entrants[i].name, s->played, s->wins,
+               s->points_for, s->points_against, points > 0 ? (double)s->hits / points : 0.0, s->longest_rally);
+    }
+}
+
+static void print_summary(const TournamentResult *result, int threads) {
+    printf("%d matches, %lld points, %lld ticks on %d threads in %.3f s (%.1f matches/sec)\n", result->matches,
+           result->points, result->ticks, threads, result->elapsed, result->matches / result->elapsed);
+    printf("digest %016llx\n", (unsigned long long)result->digest);
+}
+
+// Plays the same tournament on 1..N threads and checks that every run agrees
+static int run_scaling(const TournamentOptions *options) {
+    double baseline = 0;
+    uint64_t digest = 0;
+
+    printf("%7s %10s %12s %8s %10s %8s\n", "threads", "seconds", "matches/sec", "speedup", "efficiency", "steals");
+    for (int threads = 1; threads <= options->threads; threads++) {
+        ThreadPool *pool = thread_pool_create(threads);
+        TournamentResult result;
+        if (pool == NULL || !run_tournament(pool, options, &result)) {
+            thread_pool_destroy(pool);
+            fprintf(stderr, "Failed to run the tournament on %d threads\n", threads);
+            return -1;
+        }
+
+        long long steals = 0;
+        for (int i = 0; i < threads; i++) {
+            steals += thread_pool_stats(pool, i)->steals;
+        }
+        thread_pool_destroy(pool);
+
+        if (threads == 1) {
+            baseline = result.elapsed;
+            digest = result.digest;
+        }
+        double speedup = baseline / result.elapsed;
+        printf("%7d %10.3f %12.1f %8.2f %9.0f%% %8lld\n", threads, result.elapsed, result.matches / result.elapsed,
+               speedup, 100 * speedup / threads, steals);
+
+        bool same = result.digest == digest;
+        free_tournament_result(&result);
+        if (!same) {
+            fprintf(stderr, "Results on %d threads differ from the single-threaded run\n", threads);
+            return -1;
+        }
+    }
+
+    printf("all runs produced digest %016llx\n", (unsigned long long)digest);
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    TournamentOptions options = {
+        .format = FORMAT_ROUND_ROBIN,
+        .games = 10,
+        .rounds = 0,
+        .threads = hardware_thread_count(),
+        .seed = 1,
+        .dt = HEADLESS_DEFAULT_DT,
+    };
+    bool scaling = false;
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        bool has_value = i + 1 < argc;
+
+        if (strcmp(arg, "--format") == 0 && has_value && parse_tournament_format(argv[i + 1], &options.format)) {
+            i++;
+        } else if (strcmp(arg, "--games") == 0 && has_value) {
+            options.games = atoi(argv[++i]);
+        } else if (strcmp(arg, "--rounds") == 0 && has_value) {
+            options.rounds = atoi(argv[++i]);
+        } else if (strcmp(arg, "--threads") == 0 && has_value) {
+            options.threads = atoi(argv[++i]);
+        } else if (strcmp(arg, "--seed") == 0 && has_value) {
+            options.seed = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(arg, "--dt") == 0 && has_value) {
+            options.dt = strtof(argv[++i], NULL);
+        } else if (strcmp(arg, "--scaling") == 0) {
+            scaling = true;
+        } else {
+            print_usage(argv[0]);
+            return -1;
+        }
+    }
+
+    if (options.rounds <= 0) {
+        options.rounds = 2 * tournament_entrant_count;
+    }
+    if (options.games <= 0 || options.threads <= 0 || options.dt <= 0) {
+        fprintf(stderr, "--games, --threads and --dt must be positive\n");
+        return -1;
+    }
+
+    if (scaling) {
+        return run_scaling(&options);
+    }
+
+    ThreadPool *pool = thread_pool_create(options.threads);
+    if (pool == NULL) {
+        fprintf(stderr, "Failed to start %d threads\n", options.threads);
+        return -1;
+    }
+
+    TournamentResult result;
+    if (!run_tournament(pool, &options, &result)) {
+        thread_pool_destroy(pool);
+        fprintf(stderr, "Failed to run the tournament\n");
+        return -1;
+    }
+
+    print_standings(&options, &result);
+    print_summary(&result, options.threads);
+
+    free_tournament_result(&result);
+    thread_pool_destroy(pool);
+    return 0;
+}
@@ -0,0 +1,28 @@
+#include "triple_buffer.h"
+
+void triple_buffer_init(TripleBuffer *buffer, const GameSnapshot *initial) {
+    for (int i = 0; i < 3; i++) {
+        buffer->slots[i] = *initial;
+    }
+    buffer->back = 0;
+    atomic_init(&buffer->spare, 1);
+    buffer->front = 2;
+}
+
+GameSnapshot *triple_buffer_back(TripleBuffer *buffer) {
+    return &buffer->slots[buffer->back];
+}
+
+void triple_buffer_publish(TripleBuffer *buffer) {
+    // Release makes the slot's contents visible to whoever acquires it
+    unsigned old = atomic_exchange_explicit(&buffer->spare, buffer->back | TRIPLE_BUFFER_FRESH, memory_order_acq_rel);
+    buffer->back = old & 3;
+}
+
+const GameSnapshot *triple_buffer_read(TripleBuffer *buffer) {
+    if (atomic_load_explicit(&buffer->spare, memory_order_relaxed) & TRIPLE_BUFFER_FRESH) {
+        unsigned old = atomic_exchange_explicit(&buffer->spare, buffer->front, memory_order_acq_rel);
+        buffer->front = old & 3;
+    }
+    return &buffer->slots[buffer->front];
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <stdatomic.h>
+#include <stdint.h>
+
+#include "sim.h"
+
+// Hands the simulation's latest state to the renderer without locks. The
+// writer always has a slot of its own to fill and the reader always keeps the
+// one it is drawing; publishing swaps the writer's slot with the spare, and
+// reading takes the spare if something newer was published. Neither side ever
+// waits, and the reader only ever sees whole snapshots.
+
+typedef struct {
+    Match match;
+    // The state one tick earlier, for render interpolation
+    Match prev_match;
+    uint64_t tick;
+    // SDL performance counter when the tick was simulated
+    uint64_t tick_time;
+    // Latency probe sequence of the input this tick used
+    uint32_t input_sequence;
+} GameSnapshot;
+
+typedef struct {
+    GameSnapshot slots[3];
+    // Index of the spare slot, plus TRIPLE_BUFFER_FRESH when it is newer than the reader's
+    atomic_uint spare;
+    unsigned back;
+    unsigned front;
+} TripleBuffer;
+
+#define TRIPLE_BUFFER_FRESH 4u
+
+void triple_buffer_init(TripleBuffer *buffer, const GameSnapshot *initial);
+
+// Writer side: fill the back slot, then publish it
+GameSnapshot *triple_buffer_back(TripleBuffer *buffer);
+void triple_buffer_publish(TripleBuffer *buffer);
+
+// Reader side: the newest published snapshot, valid until the next call
+const GameSnapshot *triple_buffer_read(TripleBuffer *buffer);